@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ *  abc.h
+ *
+ *  Likelihood-free fitting of PONI parameters by Approximate Bayesian
+ *  Computation with Sequential Monte Carlo (ABC-SMC, Toni et al. '09,
+ *  Beaumont et al. '09).
+ *
+ *  A model is a PONI cell carrying all the parameters (the fitted ones are
+ *  overwritten for each particle) and a summary statistic, a function of the
+ *  cell returning a vector of numbers (e.g. the boundary positions of the
+ *  pattern in the gradient of PONIpattern) that is compared with a target
+ *  by Euclidean distance. Priors are uniform in the parameter, or in its
+ *  logarithm. At each generation the tolerance is the 'alpha'-quantile of the
+ *  distances of the previous population, and particles are proposed from the
+ *  previous population with a Gaussian kernel of twice its weighted variance.
+ *
+ *  Proposals are drawn (with ranlxd) by the calling thread and the summary
+ *  statistics are evaluated in parallel, in batches, on 'threads' threads;
+ *  particles are accepted in order of proposal, so that the results do not
+ *  depend on the number of threads. The generator of each thread is its
+ *  own, so stochastic simulations must seed it (e.g. from the parameters)
+ *  for the results to be reproducible.
+ *
+ *  Population file (text, one per generation):
+ *
+ *    # generation <t> epsilon <eps> simulations <n>
+ *    # parameters <name> ...
+ *    # rng <state of ranlxd (rlxd_get)>
+ *    <weight> <distance> <parameter values> ...     (one line per particle)
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef ABC_H
+#define ABC_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include "grn/poni.h"
+
+using namespace std;
+
+
+// summary statistic of a cell (with all its parameters set)
+typedef function<vector<double>(const PONI&)> ABC_summary_t;
+
+// summaries of the deterministic pattern in the gradient of PONIpattern,
+// from the lengths of the domains where Nkx, Olig and Pax are dominant
+// (always of the same size, so that the distance is finite even when a
+// domain is missing)
+
+// ventral boundaries of the Olig and Pax domains (Nkx, Nkx + Olig lengths)
+vector<double> patternBoundaries (const PONI& cell);
+
+// lengths of the Nkx, Olig and Pax domains
+vector<double> domainWidths (const PONI& cell);
+
+
+struct ABCParameter {
+    string name;
+    double lo, hi;      // support of the prior
+    bool log;           // prior uniform in the logarithm
+};
+
+struct ABCParticle {
+    vector<double> theta;   // parameters (not transformed)
+    double w;               // normalized weight
+    double d;               // distance from the target
+};
+
+
+class ABCSMC {
+
+private:
+
+    PONI model;
+    ABC_summary_t summary;
+    vector<double> target;
+
+    vector<ABCParticle> pop;
+    int gen;
+    double eps;
+    long sims;
+
+    double distance (const vector<double>& s) const;
+    vector<double> evaluate (const vector<vector<double>>& thetas) const;
+
+    double toU (int k, double v) const;     // to the space of the prior
+    double fromU (int k, double u) const;
+
+public:
+
+    vector<ABCParameter> pars;
+    int particles;      // size of the population
+    double alpha;       // quantile of the distances giving the next tolerance
+    int threads;
+    long maxSims;       // simulations per generation before giving up
+
+    ABCSMC (const PONI& cell, ABC_summary_t stat, const vector<double>& data);
+
+    void addParameter (string name, double lo, double hi, bool log = false);
+
+    // sample the next population (generation 0 from the prior)
+    void step ();
+
+    int generation () const { return gen; }
+    double epsilon () const { return eps; }
+    long simulations () const { return sims; }
+    const vector<ABCParticle>& population () const { return pop; }
+
+    // weighted mean of the parameters
+    vector<double> mean () const;
+
+    // population files, with the state of ranlxd: continuing from a
+    // population read from file gives the same results as without stopping
+    void write (const char* filename) const;
+    void read (const char* filename);
+};
+
+
+#endif
@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ *  batch.h
+ *
+ *  Batch of n PONI cells sharing one parameter set, stored as structure of
+ *  arrays: the state is x[k*n + i] (gene k = Pax, Olig, Nkx, Irx of cell i)
+ *  and the effectors h[k*n + i] (k = GliA, GliR).
+ *
+ *  The state array can be owned by the caller (passed to the constructor):
+ *  the batch then evolves it in place, so that the states are read without
+ *  copies. Otherwise the batch allocates it and sets all the cells to the
+ *  state of the given cell.
+ *
+ *  The factors of the production rates that depend on the effectors are
+ *  folded per cell when these are set, as in the plan of PONI.
+ *
+ *  Selected parameters can take one value per cell (extrinsic noise), set
+ *  from an array or drawn around the shared value. Only these are stored
+ *  per cell, as columns of n values (rescaled as in PONI::assignParameters)
+ *  next to the state; the kernel reads the others with stride 0, and runs
+ *  as before while no parameter is per cell.
+ *
+ *  Each step of evolve() is the same Euler(-Maruyama) step of PONI::evolve
+ *  for all the cells: deterministic steps are identical to those of PONI,
+ *  while in stochastic steps the gaussian numbers of all the cells are
+ *  drawn in one block from the streams of ranlxdv (with gauss_dblev), as are
+ *  those of the redraws. If the calling thread has not initialized ranlxdv,
+ *  the first stochastic step does so with BATCH_STREAMS streams and a seed
+ *  drawn from ranlxd.
+ *
+ *  With delays, the production of gene k at time t depends on the levels of
+ *  its regulators at t - tau_k (delay-differential equations, and their
+ *  Langevin version with the noise of the rates at t). The past states are
+ *  kept in a ring buffer of lag = round(tau/dt) + 1 states per cell, in the
+ *  same structure of arrays (rows padded to a cache line), so that memory
+ *  and the cost of a step do not grow with time.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+#define BATCH_LOGNORMAL 0   // log-normal, mean = shared value
+#define BATCH_UNIFORM 1     // uniform, centred on the shared value
+
+#define BATCH_STREAMS 16    // streams of ranlxdv seeded by the batch
+
+
+class PONIbatch {
+
+private:
+
+    PONI par;           // parameters
+    int n;
+    double* x;          // state, 4 x n
+    vector<double> own; // storage of the state if not owned by the caller
+    vector<double> h;   // effectors, 2 x n
+    vector<double> kO;  // K_Pol C_Pol G(h) of Olig and Nkx, per cell (as
+    vector<double> kN;  // the plan of PONI, rebuilt with the effectors)
+    vector<double> kP;  // same for Pax and Irx, used with per-cell
+    vector<double> kI;  // parameters
+    vector<double> g;   // gaussian numbers of a step (rows of ranlxdv)
+    vector<double> gs;  // spare numbers of the step, for redraws
+
+    // per-cell parameters: column of each parameter (in the order of
+    // PONI::parameterNames, -1 if shared) in pc (ncolumns x n)
+    vector<int> pcol;
+    vector<double> pc;
+
+    // delays: lags (in steps) of the regulators of each gene, ring buffer of
+    // 'slots' past states (rows of 'stride' >= n doubles from the first
+    // cache line of hist), the next of which is 'head'
+    int lag[4];
+    double dtDelay;
+    int slots, stride;
+    long head;
+    vector<double> hist;
+    double* history ();
+    const double* history () const;
+    void copyHistory (const PONIbatch& b);
+
+    // column of a parameter: per cell, or the shared value with stride 0
+    struct column {
+        const double* p;
+        int inc;
+        template <bool het>
+        double at (int i) const { return het ? p[inc*i] : *p; }
+    };
+
+    void gaussians (int m);
+    void spares ();
+
+    void makePlan ();
+    int parameterIndex (const string& key) const;
+    column param (int j) const;
+
+    template <bool het>
+    void step (double dt, bool stoch, const double* w);
+
+public:
+
+    PONIbatch (const PONI& cell, int ncells, double* state = NULL);
+    PONIbatch (const PONIbatch& b);
+    PONIbatch& operator= (const PONIbatch& b);
+
+    int size () const { return n; }
+
+    double* state () { return x; }
+    const double* state () const { return x; }
+    const double* effectors () const { return h.data(); }
+
+    void setState (int i, const PONI_x_t& xi);
+    PONI_x_t getState (int i) const;
+
+    // same effector for all the cells, or one per cell (2 x n)
+    void setEffector (const PONI_h_t& eff);
+    void setEffectors (const double* eff);
+
+    // one value per cell of a parameter (in the units of the parameter
+    // files), from n values or drawn from a distribution with the shared
+    // value as centre and relative spread cv (coefficient of variation for
+    // BATCH_LOGNORMAL, half width for BATCH_UNIFORM)
+    void setParameters (const string& key, const double* values);
+    void drawParameters (const string& key, int distribution, double cv);
+    double getParameter (const string& key, int i) const;
+    bool heterogeneous () const { return !pc.empty(); }
+
+    // delays of the production of Pax, Olig, Nkx, Irx (multiples of the
+    // step dt of the following steps, which must not change); the history
+    // before is the current state of the cells
+    void setDelays (const PONI_x_t& tau, double dt);
+    bool delayed () const { return slots > 0; }
+    double delayStep () const { return dtDelay; }
+
+    void evolve (double dt, bool stoch);
+
+    // stochastic step with the given gaussian numbers w[4*i + k] (gene k of
+    // cell i); negative levels are set to zero instead of being drawn
+    // again, so that steps driven by the same numbers stay coupled (MLMC)
+    void evolve (double dt, const double* w);
+
+    // round(T/dt) steps
+    void advance (double T, double dt, bool stoch);
+
+    // same, from time t0 with the effectors (the same for all the cells) of
+    // a schedule (grn/schedule.h)
+    void advance (double T, double dt, bool stoch, const Schedule& s, double t0);
+
+    // binary serialization (parameters, state, effectors, per-cell
+    // parameters, delays and their history)
+    void write (ostream& os) const;
+    void read (istream& is);
+};
+
+
+#endif
@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ *  checkpoint.h
+ *  
+ *  Checkpoint of a simulation: PONI objects (state, effector, parameters),
+ *  batches and lattices of cells, position in the loops of the driver and
+ *  state of the generators ranlxd and ranlxdv of the calling thread (the
+ *  tiles of a lattice have their own, saved with the lattice).
+ *
+ *  Binary format (native byte order):
+ *
+ *    char[8]   "PONICKP2"
+ *    int       phase, rng (1 if the state of the generators follows)
+ *    long      step, lines
+ *    double    t
+ *    int       number of loop variables, followed by as many doubles
+ *    int[105]  state of ranlxd (rlxd_get), only if rng = 1
+ *    int       size of the state of ranlxdv (0 if not initialized),
+ *              followed by the state (rlxdv_get), only if rng = 1
+ *    int       number of PONI objects, followed by PONI::write of each
+ *    int       number of batches, followed by PONIbatch::write of each
+ *    int       number of lattices, followed by PONIlattice::write of each
+ *
+ *  Files of the previous format ("PONICKP1", without ranlxdv, batches and
+ *  lattices) are still read.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/lattice.h"
+
+using namespace std;
+
+
+class Checkpoint {
+
+public:
+
+    int phase;              // phase of the driver (e.g. prepattern, pattern)
+    long step;              // integration steps since the beginning
+    long lines;             // lines of output already produced
+    double t;               // time of the innermost loop
+    vector<double> loop;    // other loop variables (e.g. position)
+    bool rng;               // save/restore the state of the generators
+    vector<PONI> cells;     // all the PONI objects of the simulation
+    vector<PONIbatch> batches;
+    vector<PONIlattice> lattices;
+
+    Checkpoint ();
+
+    // the file is first written as "filename.tmp" and then renamed,
+    // so that a previous checkpoint is never left half-written
+    void write (const char* filename) const;
+    void read (const char* filename);
+};
+
+
+#endif
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ *  continuation.h
+ *
+ *  Pseudo-arclength continuation of the fixed points of the PONI network
+ *  as a function of the level of Gli.
+ *
+ *  The effector moves on the segment h(g) = (1-g) hR + g hA, with hR the
+ *  repressive input (GliA = 0, GliR = 1) and hA the activating one (GliA = 1,
+ *  GliR = 0) by default, so that g is GliA along the gradient of PONIpattern.
+ *  Each point of a branch carries the largest real part of the eigenvalues
+ *  of the Jacobian (stable if negative); folds (saddle-nodes) are located
+ *  where the g-component of the tangent changes sign.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef CONTINUATION_H
+#define CONTINUATION_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+struct BifPoint {
+    double g;           // level of Gli
+    PONI_x_t x;         // fixed point
+    double lambda;      // largest real part of the eigenvalues of the Jacobian
+    bool stable;
+    bool fold;          // saddle-node
+};
+
+
+class Continuation {
+
+private:
+
+    typedef Matrix<double,5,1> y_t;     // (x, g)
+
+    PONI grn;
+    PONI_h_t hR, hA;
+
+    y_t tangent (const y_t& y, const y_t& prev);
+    bool correct (y_t& y, const y_t& t, const y_t& yp);
+    BifPoint point (const y_t& y, bool fold);
+
+    PONI_x_t F (const PONI_x_t& x, double g);
+    PONI_J_t Jx (const PONI_x_t& x, double g);
+    PONI_x_t Fg (const PONI_x_t& x, double g);
+
+public:
+
+    double ds;          // initial step in arclength
+    double dsMin;
+    double dsMax;
+    double tol;         // tolerance of the Newton iterations
+    int maxIter;        // Newton iterations per step
+    int maxSteps;       // steps per branch
+    double gMin, gMax;  // range of g
+
+    Continuation (const PONI& net);
+    Continuation (const PONI& net, PONI_h_t repressive, PONI_h_t activating);
+
+    PONI_h_t effector (double g) const;
+
+    // fixed point at g, by integration from x and Newton refinement
+    bool steadyState (double g, PONI_x_t& x);
+
+    // trace the branch through the fixed point x at g, moving initially
+    // towards increasing (dir > 0) or decreasing (dir < 0) g
+    vector<BifPoint> branch (double g, PONI_x_t x, int dir);
+};
+
+
+#endif
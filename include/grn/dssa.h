@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ *  dssa.h
+ *
+ *  Exact stochastic simulation of a PONI cell with transcriptional delays
+ *  (delayed SSA, Cai '07): the production of gene k is initiated with the
+ *  propensity Omega prodR_k of the current state and completes (adding one
+ *  copy of the protein) tau_k later, while degradation is immediate.
+ *
+ *  The initiated productions of each gene complete in the order in which
+ *  they were initiated, so they are kept in a ring buffer of completion
+ *  times per gene (FIFO, doubled when full). Between two reactions the next
+ *  completion, if earlier than the next initiation or degradation, is
+ *  applied first and the waiting time is drawn again from the new
+ *  propensities (they are memoryless).
+ *
+ *  The state is the copy number n_k = Omega x_k of each gene (rounded when
+ *  set). When the state is set, the history is taken constant (as in
+ *  PONIbatch::setDelays), and the productions initiated in the delay before
+ *  are drawn. Unlike the delay-differential equations of PONIbatch, where
+ *  only the regulators are delayed, here the effectors are delayed too
+ *  (the two agree while these are constant). With zero delays the
+ *  simulation is the SSA of PONIhybrid with all the genes discrete. The
+ *  numbers are drawn with ranlxd.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef DSSA_H
+#define DSSA_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+class PONIdssa {
+
+private:
+
+    PONI c;
+    PONI_x_t tau;       // delays of the production
+    long cnt[4];        // copy numbers
+    double t;           // time
+
+    // completion times of the initiated productions of each gene, from
+    // first[k] (count[k] of them, capacity of ring[k] a power of 2)
+    vector<double> ring[4];
+    int first[4], count[4];
+
+    void push (int k, double tc);
+
+public:
+
+    long events;        // reactions (initiations, completions, degradations)
+
+    PONIdssa (const PONI& cell, const PONI_x_t& delays);
+
+    // the initiated productions are replaced by those of a constant history
+    // (with the current effectors)
+    void setState (const PONI_x_t& x);
+    PONI_x_t getState () const { return c.getState(); }
+    void setEffector (const PONI_h_t& eff) { c.setEffector(eff); }
+    double time () const { return t; }
+    int pending (int k) const { return count[k]; }
+
+    // simulation until time() + T
+    void advance (double T);
+};
+
+
+#endif
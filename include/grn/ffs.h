@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ *  ffs.h
+ *
+ *  Forward flux sampling (Allen et al. '05) of the stochastic switching of a
+ *  PONI cell (PONI::evolve with noise) from a state A to a state B.
+ *
+ *  The states are defined by an order parameter lambda(x) and interfaces
+ *  lambda_0 < ... < lambda_n: A is lambda < lambdaA (<= lambda_0, default
+ *  lambda_0) and B is lambda >= lambda_n.
+ *
+ *  - Stage 0: 'walkers' trajectories started from the initial cell collect
+ *    'points' crossings of lambda_0 coming from A, giving the flux out of A
+ *    (crossings per unit time spent outside B); a trajectory reaching B
+ *    starts again from the initial cell.
+ *
+ *  - Stage i: 'trials' trajectories from random crossings of lambda_{i-1}
+ *    run until they reach lambda_i (success, a new crossing) or go back to
+ *    A (failure), giving the probability P_i.
+ *
+ *  The rate is k_AB = flux * prod_i P_i. Each successful trial stores its
+ *  path (every 'stride' steps) and its parent crossing, so that the paths
+ *  reaching B can be traced back to A (transition path ensemble).
+ *
+ *  Walkers and trials are independent tasks distributed over 'threads'
+ *  threads. Task k uses ranlxd seeded with seed+k (the state of ranlxd is
+ *  private to each thread), so that the results do not depend on the
+ *  number of threads.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef FFS_H
+#define FFS_H
+
+#include <vector>
+#include <functional>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+typedef function<double(const PONI_x_t&)> FFS_order_t;
+typedef vector<PONI_x_t, aligned_allocator<PONI_x_t>> FFS_path_t;
+
+
+class FFS {
+
+private:
+
+    struct crossing {
+        PONI cell;          // configuration at the interface
+        int parent;         // crossing of the previous interface (-1 at 0)
+        FFS_path_t path;    // segment from the parent (every 'stride' steps)
+        vector<double> ts;  // times of the states of the segment
+    };
+
+    PONI start;
+    FFS_order_t lambda;
+    vector<double> iface;
+
+    vector<vector<crossing>> cross;   // crossings of each interface
+    double phi;                         // flux through lambda_0
+    vector<double> prob;                // P_i, i = 1...n
+    vector<long> fails;                 // trials timed out, per interface
+
+    void stage0 ();
+    void stage (int i);
+
+public:
+
+    double lambdaA;     // boundary of A (NAN: lambda_0)
+    double dt;
+    int walkers;        // independent trajectories of stage 0
+    int points;         // crossings of lambda_0 to collect
+    int trials;         // trials per interface
+    int stride;         // steps between stored states of the paths
+    long maxSteps;      // steps before a trial is given up (as a failure)
+    int threads;
+    int seed;
+
+    FFS (const PONI& cell, FFS_order_t order, const vector<double>& interfaces);
+
+    void run ();
+
+    double flux () const { return phi; }
+    const vector<double>& probabilities () const { return prob; }
+    double rate () const;
+
+    // trials given up after maxSteps, per interface
+    const vector<long>& timeouts () const { return fails; }
+
+    // transition paths, from A to B, with the times of their states
+    vector<FFS_path_t> paths (vector<vector<double>>* times = NULL) const;
+};
+
+
+#endif
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  gmam.h
+ *
+ *  Minimum action paths of the PONI network by the geometric minimum action
+ *  method (Heymann and Vanden-Eijnden '08).
+ *
+ *  With the noise of PONI::evolve, dx = b dt + sqrt(a/Omega) dW, where b is
+ *  the drift and a = diag(prodR + delta*x), the probability of a transition
+ *  between two fixed points is ~ exp(-Omega*S), with S the minimum over the
+ *  paths phi of the geometric action
+ *
+ *      S[phi] = int ( |phi'|_a |b|_a - <phi', b>_a ) ds,   <u,v>_a = u a^-1 v.
+ *
+ *  The path between the fixed endpoints is discretized on 'nodes' points and
+ *  relaxed by the semi-implicit gMAM iteration (the second derivative along
+ *  the path is implicit), redistributing the nodes at equal arclength after
+ *  each step. For a path from a stable state A to a stable state B, the
+ *  action accumulated along the path is the quasi-potential of A, and its
+ *  maximum (the total action) the barrier, reached at the saddle.
+ *
+ *  Each GMAM works on its own copy of the cell and does not use random
+ *  numbers, so that different transitions can be relaxed on parallel
+ *  threads.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef GMAM_H
+#define GMAM_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+typedef vector<PONI_x_t, aligned_allocator<PONI_x_t>> GMAM_path_t;
+
+
+class GMAM {
+
+private:
+
+    PONI grn;
+    double delta;
+
+    GMAM_path_t phi;        // nodes, from A to B
+    vector<double> V;       // action accumulated up to each node
+    double res;             // residual of the last iteration
+
+    void local (const PONI_x_t& x, PONI_x_t& b, PONI_x_t& a, PONI_J_t& J);
+    void reparametrize (int n);
+    void accumulate ();
+
+public:
+
+    double tau;     // step of the relaxation
+    int maxIter;
+    double tol;     // on the largest displacement of the nodes over tau
+
+    GMAM (const PONI& cell, const PONI_x_t& xA, const PONI_x_t& xB, int nodes = 100);
+
+    // initial path (e.g. a transition path of FFS), resampled on the nodes
+    void setPath (const GMAM_path_t& path);
+
+    // relax the path, returns the number of iterations (maxIter if it did
+    // not converge)
+    int relax ();
+    double residual () const { return res; }
+
+    const GMAM_path_t& path () const { return phi; }
+    double action () const { return V.back(); }
+
+    // action accumulated along the path (quasi-potential from A)
+    const vector<double>& quasiPotential () const { return V; }
+
+    // saddle crossed by the path: fixed point of the drift found by Newton's
+    // method from the interior node where the drift is the smallest
+    PONI_x_t saddle ();
+};
+
+
+#endif
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ *  hybrid.h
+ *
+ *  Hybrid simulation of a PONI cell: the genes with few copies are simulated
+ *  exactly (Gillespie's SSA) and the others with the chemical Langevin
+ *  equation of PONI::evolve.
+ *
+ *  With n_k = Omega x_k the copy number of gene k, the reactions of the gene
+ *  are production (propensity Omega prodR_k) and degradation (Omega delta
+ *  x_k), changing n_k by +-1. At the beginning of each step of length dt
+ *  each gene is classified:
+ *
+ *    - continuous -> discrete if n_k < threshold; n_k is rounded to an
+ *      integer at random (up with probability equal to its fractional part,
+ *      so that the mean is kept)
+ *    - discrete -> continuous if n_k > hysteresis * threshold
+ *
+ *  The continuous genes take the Euler-Maruyama step of PONI::evolve (with
+ *  the same redraws of negative states), and the reactions of the discrete
+ *  ones are simulated exactly over the step, with the continuous genes held
+ *  at their value at the beginning of the step (the error is of the order
+ *  of that of the Euler step). With a large threshold the simulation is the
+ *  SSA of the whole network, with threshold 0 it is PONI::evolve.
+ *
+ *  The numbers are drawn with ranlxd (gaussian ones with gauss_dble).
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+class PONIhybrid {
+
+private:
+
+    PONI c;
+    bool disc[4];   // genes simulated with the SSA
+    long cnt[4];    // their copy numbers
+
+    void classify ();
+
+public:
+
+    double threshold;   // copy number below which a gene is discrete
+    double hysteresis;  // discrete genes are continuous above hysteresis*threshold
+
+    long events;        // reactions simulated exactly
+    long discSteps;     // steps of the genes in the discrete regime
+    long contSteps;     // steps of the genes in the continuous regime
+
+    PONIhybrid (const PONI& cell);
+
+    void setState (const PONI_x_t& x);
+    PONI_x_t getState () const { return c.getState(); }
+    void setEffector (const PONI_h_t& eff) { c.setEffector(eff); }
+    const PONI& cell () const { return c; }
+    bool discrete (int k) const { return disc[k]; }
+
+    void evolve (double dt);
+
+    // round(T/dt) steps
+    void advance (double T, double dt);
+};
+
+
+#endif
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ *  lattice.h
+ *
+ *  Lattice of nx x ny PONI cells (one parameter set) with coupling between
+ *  neighbours (juxtacrine or paracrine signals).
+ *
+ *  The state is stored as structure of arrays, x[k*n + i] with the cell
+ *  i = ix + nx*iy, in two buffers: each step reads one and writes the other
+ *  (the pointer returned by state() changes at each step), so that the cells
+ *  can be updated in any order and by several threads without races.
+ *
+ *  A coupling acts on the production of a target gene through the signal
+ *  s_i = sum_j w_j x_source(i + d_j) of a stencil (offsets d_j with weights
+ *  w_j, by default the mean of the nearest neighbours), as the activation by
+ *  Gli does: the factor K_Pol C_Pol of the target is multiplied by
+ *
+ *    (1 + f K s)/(1 + K s)
+ *
+ *  (f > 1 activation, f < 1 repression). At the edges the neighbours are
+ *  those of the nearest cell on the lattice (no flux). The neighbours of
+ *  each cell are tabulated when the stencil is set, so that each step is a
+ *  branchless sweep over the cells.
+ *
+ *  The cells are split in 'tiles' contiguous tiles, updated by 'threads'
+ *  threads in advance(); each tile has its own ranlxdv generator, with
+ *  LATTICE_STREAMS streams seeded with seed + LATTICE_STREAMS*tile, ... at
+ *  the first stochastic step, whose gaussian numbers (gauss_dblev) are
+ *  drawn in one block per tile and step. The results do not depend on the
+ *  number of threads, and the generators of the calling thread are not
+ *  touched. With no couplings the steps are those of PONIbatch.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <vector>
+#include <string>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+#define LATTICE_STREAMS 8   // streams of the generator of a tile
+
+
+class PONIlattice {
+
+private:
+
+    PONI par;               // parameters
+    int nx, ny, n;
+    vector<double> buf[2];  // states, 4 x n each
+    int cur;                // buffer with the current state
+    vector<double> h;       // effectors, 2 x n
+    vector<double> kO;      // K_Pol C_Pol G(h) of Olig and Nkx, per cell
+    vector<double> kN;
+    vector<vector<double>> gt;  // gaussian numbers of a step, per tile
+    vector<double> gc;      // coupling factors of the production, 4 x n
+    vector<double> sc;      // signals of a coupling
+
+    // stencil: weights and neighbours nb[j*n + i] of each cell
+    vector<int> sx, sy;
+    vector<double> sw;
+    vector<int> nb;
+
+    struct coupling {
+        int target, source;
+        double K, f;
+    };
+    vector<coupling> couplings;
+
+    vector<vector<int>> rng;    // generators of the tiles (ranlxdv)
+
+    void makePlan ();
+    void makeNeighbours ();
+    void sweep (int t, int a, int b, const double* x, double* y, double dt,
+                bool stoch);
+    void run (long steps, double dt, bool stoch);
+
+public:
+
+    int tiles;      // tiles of cells (fixed, they define the generators)
+    int threads;    // threads of advance()
+    int seed;       // seed of the generator of tile 0
+
+    PONIlattice (const PONI& cell, int width, int height = 1);
+
+    int size () const { return n; }
+    int width () const { return nx; }
+    int height () const { return ny; }
+
+    double* state () { return buf[cur].data(); }
+    const double* state () const { return buf[cur].data(); }
+
+    void setState (int i, const PONI_x_t& xi);
+    PONI_x_t getState (int i) const;
+
+    // same effector for all the cells, or one per cell (2 x n)
+    void setEffector (const PONI_h_t& eff);
+    void setEffectors (const double* eff);
+
+    // offsets (dx, dy) of the neighbours and their weights
+    void setStencil (const vector<int>& dx, const vector<int>& dy,
+                     const vector<double>& w);
+
+    // genes by name (Pax, Oli, Nkx, Irx)
+    void addCoupling (const string& target, const string& source, double K, double f);
+
+    // one step, or round(T/dt) steps on 'threads' threads (stochastic steps
+    // always run on new threads, so advance is preferable to many evolve)
+    void evolve (double dt, bool stoch);
+    void advance (double T, double dt, bool stoch);
+
+    // binary serialization (parameters, state, effectors, stencil,
+    // couplings and the generators of the tiles)
+    void write (ostream& os) const;
+    void read (istream& is);
+};
+
+
+#endif
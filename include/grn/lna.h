@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ *  lna.h
+ *
+ *  Mean and covariance of the protein levels of a PONI cell from a single
+ *  deterministic solve, instead of replicas of PONI::evolve(dt, true).
+ *
+ *  The noise of PONI::evolve has covariance D/Omega per unit time, with
+ *  D = diag(prodR + delta x). The moments evolve as
+ *
+ *    d mu/dt    = F(mu) + c
+ *    d Sigma/dt = J Sigma + Sigma J^T + (D(mu) + diag(c))/Omega
+ *
+ *  with J the Jacobian of the drift F at mu. The closure sets c:
+ *
+ *    LNA_LINEAR      c = 0, linear noise approximation
+ *    LNA_GAUSSIAN    c_i = 1/2 tr(H_i Sigma), with H_i the Hessian of F_i
+ *                    (second-order, Gaussian closure: third central moments
+ *                    vanish), which corrects the mean and the diffusion
+ *
+ *  Both are integrated with Euler steps as PONI::evolve.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef LNA_H
+#define LNA_H
+
+#include <iostream>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+enum { LNA_LINEAR, LNA_GAUSSIAN };
+
+
+class LNA {
+
+private:
+
+    PONI grn;           // carries the mean, parameters and effector
+    PONI_J_t Sigma;     // covariance
+    int closure;
+    double Omega;
+
+    PONI_x_t correction (const PONI_x_t& mu);
+
+public:
+
+    // mean from the state of 'cell', zero covariance
+    LNA (const PONI& cell, int closure = LNA_LINEAR);
+
+    void setEffector (PONI_h_t eff);
+    void setState (PONI_x_t mu);
+    void setCovariance (const PONI_J_t& cov);
+
+    PONI_x_t getMean () const;
+    PONI_J_t getCovariance () const;
+    PONI_x_t getStd () const;
+
+    void evolve (double dt);
+
+    // mean and standard deviations
+    friend ostream& operator<< (ostream& os, const LNA& lna);
+};
+
+
+#endif
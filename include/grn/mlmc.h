@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *  mlmc.h
+ *
+ *  Multilevel Monte Carlo (Giles '08) estimate of the expectation of a
+ *  function P of a batch of PONI cells (e.g. the position of a boundary of
+ *  the pattern) evolved with noise for a time T.
+ *
+ *  Level l uses the step dt_l = dt0/M^l, and its samples are the differences
+ *  Y_l = P_l - P_(l-1) of pairs of paths (Y_0 = P_0) driven by the same
+ *  gaussian numbers: each step of the coarse path uses the sum of those of
+ *  the M steps of the fine path, divided by sqrt(M). All the levels use the
+ *  Euler-Maruyama step of PONIbatch::evolve(dt, w), where negative levels are
+ *  set to zero, so that the sum of the expectations of the Y_l telescopes
+ *  to that of P_L.
+ *
+ *  estimate(eps) adds levels until the bias of the finest one, estimated
+ *  as |E[Y_L]|/(M^alpha - 1) (alpha weak order, 1 for Euler), is below
+ *  eps/sqrt(2), and takes on each level the number of samples which gives
+ *  a variance eps^2/2 at the least cost (N_l proportional to
+ *  sqrt(V_l/C_l), with C_l the steps of a sample).
+ *
+ *  The samples are drawn in chunks of 'chunk', which are independent tasks
+ *  distributed (all the levels together) over 'threads' threads. Chunk c of
+ *  level l uses ranlxd seeded with a number given by seed, l and c, so that
+ *  the results do not depend on the number of threads.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef MLMC_H
+#define MLMC_H
+
+#include <vector>
+#include <functional>
+#include "grn/poni.h"
+#include "grn/batch.h"
+
+using namespace std;
+
+
+typedef function<double(const PONIbatch&)> MLMC_payoff_t;
+
+
+class MLMC {
+
+private:
+
+    PONIbatch start;        // cells at time 0
+    MLMC_payoff_t payoff;
+
+    struct level {
+        long n;             // samples
+        long chunks;        // chunks drawn (the next one has this index)
+        double sum, sum2;   // of Y_l
+        double sumP, sumP2; // of P_l (fine paths)
+    };
+    vector<level> lev;
+
+    void sample (const vector<long>& add);
+    double steps (int l) const;
+
+public:
+
+    double T;       // time of the evolution
+    double dt0;     // step of level 0
+    int M;          // refinement factor
+    int Lmin;       // levels always used
+    int Lmax;       // largest number of levels
+    long N0;        // samples of a new level
+    int chunk;      // samples of a task
+    double alpha;   // weak order of the scheme
+    int threads;
+    int seed;
+
+    MLMC (const PONIbatch& cells, MLMC_payoff_t P);
+
+    // expectation of P with tolerance eps (root mean square error)
+    double estimate (double eps);
+
+    // results of the last estimate
+    int levels () const { return lev.size(); }
+    long samples (int l) const { return lev[l].n; }
+    double mean (int l) const;          // of Y_l
+    double variance (int l) const;      // of Y_l
+    double meanFine (int l) const;      // of P_l
+    double varianceFine (int l) const;  // of P_l
+    double cost () const;               // steps of all the samples (of one batch)
+};
+
+
+#endif
@@ -0,0 +1,187 @@
+/******************************************************************************
+ *
+ *  netgrn.h
+ *
+ *  Thermodynamic GRN with topology read at run time from a network
+ *  description file, compiled into a flat evaluation plan.
+ *
+ *  Format of the description file (one entry per line, '#' for comments):
+ *
+ *    genes       Pax Oli Nkx Irx       names of the genes
+ *    effectors   GliA GliR             names of the effectors
+ *    activators  GliA                  effectors recruiting RNA-polymerase
+ *    binder      Gli                   name in the keys of effector affinities
+ *    targets     Oli Nkx               genes bound by the effectors
+ *    repression  Oli Pax 2             regulator, target, cooperativity
+ *    initial     Pax .95               initial condition (default 0)
+ *    K_Oli_Pax   1.9                   any other line: parameter value
+ *
+ *  Parameters follow the same naming as the PONI class: K_Pol_<gene>,
+ *  alpha_<gene>, K_<binder>_<target>, K_<regulator>_<target>, f_A, C_Pol,
+ *  delta, Omega, lambdaConc, lambdaTime.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef NETGRN_H
+#define NETGRN_H
+
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <unordered_map>
+#include <Eigen/Dense>
+
+using namespace std;
+using namespace Eigen;
+
+#ifndef NET_TYPE_DEFS
+#define NET_TYPE_DEFS
+typedef unordered_map<string,int> NET_dict;
+typedef unordered_map<string,double> PAR_dict;
+#endif
+
+
+//
+//  Flat evaluation plan: per-gene constants and a table of repression
+//  terms sorted by target gene.  It is immutable once compiled, so it can be
+//  shared by any number of cells and threads.
+//
+struct NetPlan {
+
+    int N;                  // number of genes
+    int M;                  // number of effectors
+
+    vector<double> base;    // K_Pol_i * C_Pol
+    vector<double> Keff;    // affinity of the effectors (0 if not a target)
+    vector<double> alpha;   // coefficient production rate
+    vector<double> act;     // 1 for activating effectors, 0 otherwise
+    double f_A;
+    double delta;
+    double Omega;
+
+    vector<int> start;      // terms of gene i are start[i], ..., start[i+1]-1
+    vector<int> src;        // regulator
+    vector<int> coop;       // cooperativity
+    vector<double> K;       // affinity of the regulator on the target
+
+    // production of a single cell
+    void prodR (const double* x, const double* h, double* out) const;
+
+    // production of n cells stored as columns (x[gene][cell], ...)
+    void prodR (int n, const double* const* x, const double* const* h,
+                double* const* out) const;
+};
+
+
+class NetGRN {
+
+private:
+
+    vector<string> geneNames;
+    vector<string> effNames;
+    NET_dict genes;         // name -> index
+    NET_dict effectors;
+    string binder;
+
+    vector<bool> target;
+    vector<bool> activating;
+    vector<int> repTarget, repSource, repCoop;
+
+    PAR_dict pars;          // dictionary containing parameters (keys are names)
+    VectorXd x0;            // initial condition given in the description
+
+    NetPlan plan;
+
+    VectorXd x;             // state variables
+    VectorXd h;             // control/effector variables
+    VectorXd prodR;
+    VectorXd drift;
+    VectorXd noise;
+    VectorXd xp, xpp;       // work space for evolve
+
+    void readNetwork (const char* filename);
+    double parameter (const string& key);
+    void assignParameters ();   // compiles the evaluation plan
+
+    void setProdR ();
+    void setDrift ();
+    void setNoise ();
+
+public:
+
+    NetGRN (const char* filename);
+
+    int size () const;
+    int effectorSize () const;
+    const NetPlan& getPlan () const;
+
+    void setParameters (string key, double val);
+    void setParameters (const char* filename);
+    void testParameters (const char* filename);
+    void testParameters (ostream& os);
+
+    void setState (VectorXd vec);
+    void setEffector (VectorXd eff);
+
+    friend ostream& operator<< (ostream& os, const NetGRN& g);
+
+    VectorXd getInitialState () const;
+    VectorXd getState () const;
+    VectorXd getEffector () const;
+    VectorXd getDrift ();
+    VectorXd getProdR ();
+
+    void evolve (double dt, bool stoch);
+};
+
+
+//
+//  Batch of n cells with the plan of a NetGRN, stored as columns: the state
+//  is x[i*n + c] (gene i of cell c) and the effectors h[k*n + c]. Each step
+//  evaluates the production of the cells with the column evaluator of the
+//  plan, and deterministic steps are identical to those of NetGRN::evolve.
+//
+//  The cells are independent: they are split in 'tiles' contiguous tiles,
+//  each evolved for all the steps of advance() by one of 'threads' threads.
+//  As in PONIlattice each tile has its own ranlxd generator (seeded with
+//  seed + tile at the first stochastic step), so that the results do not
+//  depend on the number of threads.
+//
+class NetBatch {
+
+private:
+
+    NetPlan plan;
+    int n;
+    vector<double> x;           // state, N x n
+    vector<double> h;           // effectors, M x n
+    vector<vector<int>> rng;    // generators of the tiles
+
+    void sweep (int a, int b, long steps, double dt, bool stoch);
+
+public:
+
+    int tiles;      // tiles of cells (fixed, they define the generators)
+    int threads;    // threads of advance()
+    int seed;       // seed of the generator of tile 0
+
+    NetBatch (const NetGRN& cell, int ncells);
+
+    int size () const { return n; }
+    const double* state () const { return x.data(); }
+
+    void setState (int c, const VectorXd& xc);
+    VectorXd getState (int c) const;
+    void setEffector (int c, const VectorXd& eff);
+
+    // round(T/dt) steps
+    void advance (double T, double dt, bool stoch);
+};
+
+
+#endif
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *  networks.h
+ *
+ *  Descriptions of thermodynamic GRNs, to be used with ThermoGRN<Net>
+ *  (see grn/thermogrn.h).
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef GRNNETWORKS_H
+#define GRNNETWORKS_H
+
+#include "grn/thermogrn.h"
+
+
+//
+//  PONI network (Cohen et al. '14): Pax, Olig, Nkx, Irx
+//  regulated by Gli in its activator (GliA) and repressor (GliR) forms
+//
+struct PONInet {
+
+    static const int N = 4;
+    static const int M = 2;
+
+    // row i: cooperativity of the repression of gene i by gene j
+    static constexpr int coop (int i, int j)
+    {
+        return  "0220"      // Pax  <- Oli, Nkx
+                "0022"      // Oli  <- Nkx, Irx
+                "2202"      // Nkx  <- Pax, Oli, Irx
+                "0220"      // Irx  <- Oli, Nkx
+                [N*i + j] - '0';
+    }
+
+    // Gli binds Olig and Nkx
+    static constexpr bool target (int i) { return "0110"[i] == '1'; }
+
+    // only GliA recruits RNA-polymerase
+    static constexpr bool activating (int k) { return k == 0; }
+
+    static const char* name (int i)
+    {
+        static const char* names[N] = {"Pax", "Oli", "Nkx", "Irx"};
+        return names[i];
+    }
+
+    static PAR_dict defaults ()
+    {
+        return {
+            {"lambdaConc",1},
+            {"lambdaTime",1},
+            {"K_Pol_Pax", 4.8},
+            {"K_Pol_Oli", 47.8},
+            {"K_Pol_Nkx", 27.4},
+            {"K_Pol_Irx", 23.4},
+            {"K_Gli_Oli", 18.0},
+            {"K_Gli_Nkx", 373.},
+            {"K_Oli_Pax", 1.9},
+            {"K_Oli_Nkx", 27.1},
+            {"K_Nkx_Oli", 60.6},
+            {"K_Pax_Nkx", 4.8},
+            {"K_Nkx_Pax", 26.7},
+            {"K_Irx_Oli", 28.4},
+            {"K_Oli_Irx", 58.8},
+            {"K_Irx_Nkx", 47.1},
+            {"K_Nkx_Irx", 76.2},
+            {"f_A", 10.},
+            {"C_Pol", .8},
+            {"alpha_Pax", 2.},
+            {"alpha_Oli", 2.},
+            {"alpha_Nkx", 2.},
+            {"alpha_Irx", 2.},
+            {"delta", 2.},
+            {"Omega", 1000.},
+        };
+    }
+};
+
+typedef ThermoGRN<PONInet> ThermoPONI;
+typedef ThermoGRN<PONInet,float> ThermoPONIf;           // single precision
+typedef ThermoGRN<PONInet,float,double> ThermoPONIm;    // mixed precision
+
+typedef ThermoBatch<PONInet> ThermoPONIbatch;
+typedef ThermoBatch<PONInet,float> ThermoPONIbatchf;
+
+
+#endif
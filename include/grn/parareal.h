@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ *  parareal.h
+ *
+ *  Parallel-in-time integration (Parareal, Lions et al. '01) of a long
+ *  deterministic trajectory of a PONI cell with constant effectors, such as
+ *  the prepattern.
+ *
+ *  The nsteps steps of size dt are split in 'slices' time slices. The fine
+ *  propagator F is PONI::integrate with step dt, the coarse one G the same
+ *  with a step close to dtCoarse. After a sequential coarse run giving the
+ *  states U_n at the beginning of the slices, each iteration
+ *
+ *    - runs F on all the slices from the current U_n, in parallel on
+ *      'threads' threads
+ *    - corrects the states in sequence, U_n+1 = G(U_n) + F(U_n) - G(U_n)
+ *      (with the new U_n in the first G and the previous one in the others)
+ *
+ *  until the states change by less than tol (in any gene). After k
+ *  iterations the first k slices are exact, so at most 'slices' iterations
+ *  are needed and the wall time is about (iterations/slices) times that of
+ *  the fine run, plus the coarse runs.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef PARAREAL_H
+#define PARAREAL_H
+
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+class Parareal {
+
+private:
+
+    PONI start;         // initial state, parameters and effectors
+    long nsteps;
+    double dt;
+    int iters;
+
+    long first (int n) const;   // first fine step of slice n
+    PONI_x_t coarse (int n, const PONI_x_t& x) const;
+
+public:
+
+    int slices;
+    int threads;
+    double dtCoarse;    // step of the coarse propagator
+    double tol;         // on the change of the states at the slices
+
+    Parareal (const PONI& cell, long steps, double step);
+
+    // state after the nsteps steps
+    PONI_x_t run ();
+
+    int iterations () const { return iters; }
+};
+
+
+#endif
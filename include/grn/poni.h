@@ -21,6 +21,8 @@
 #include <tuple>
 #include <unordered_map>
 #include <Eigen/Dense>
+#include "random.h"
+#include "stats.h"
 #include "grn/global.h"
 
 using namespace std;
@@ -32,8 +34,14 @@ typedef unordered_map<string,int> NET_dict;
 typedef unordered_map<string,double> PAR_dict;
 #endif
 
+class Schedule;
+
 typedef Vector4d PONI_x_t;  // type of state variable
 typedef Vector2d PONI_h_t;  // type of effector variable
+typedef Matrix4d PONI_J_t;  // type of the Jacobian
+
+#define PONI_NPAR 25
+typedef Matrix<double,4,PONI_NPAR> PONI_P_t;  // derivatives w.r.t. parameters
 
 
 class PONI {
@@ -108,6 +116,15 @@ private:
 
     PONI_x_t prodR;  // probability of RNA-polimerase bound
 
+    // factors of the production rates which do not depend on the state,
+    // k_i = K_Pol_i C_Pol G_i(h) (G_i: activation by Gli, 1 for Pax and
+    // Irx), rebuilt by assignParameters and setEffector
+    struct {
+        double kPax, kOli, kNkx, kIrx;
+    } plan;
+
+    void makePlan ();
+
     PONI_x_t drift;
     PONI_x_t noise;
     
@@ -115,6 +132,11 @@ private:
     void setDrift ();
     void setNoise ();
 
+    friend class PONIbatch;   // read the parameters in their kernels
+    friend class PONIlattice;
+    friend class PONIhybrid;
+    friend class PONIdssa;
+
 public:
 
     // contructors
@@ -129,6 +151,7 @@ public:
 
     void setParameters(string key, double val);
     void setParameters(const char* filename);
+    double getParameter(string key) const;
     void testParameters(const char* filename);
     void testParameters(ostream& os);
 
@@ -145,10 +168,149 @@ public:
     PONI_x_t getDrift();
 
     PONI_x_t getProdR ();
+
+    PONI_J_t getJacobian ();    // derivative of the drift w.r.t. the state
+
+    // derivative of the drift w.r.t. the parameters, columns in the order
+    // of parameterNames()
+    PONI_P_t getParJacobian ();
+    static const vector<string>& parameterNames ();
     
     void evolve (double dt, bool stoch);
 
+    // nsteps steps of evolve in one kernel; observer(k, x) is called after
+    // step k (= 1...nsteps) with the state and stops the integration if it
+    // returns false. Returns the number of steps done
+    template <class Obs>
+    long integrate (long nsteps, double dt, bool stoch, Obs observer);
+    long integrate (long nsteps, double dt, bool stoch);
+
+    // same, from time t0 with the effectors of a schedule (defined in
+    // grn/schedule.h)
+    template <class Obs>
+    long integrate (long nsteps, double dt, bool stoch, const Schedule& s,
+                    double t0, Obs observer);
+    long integrate (long nsteps, double dt, bool stoch, const Schedule& s,
+                    double t0);
+
+    // binary serialization (state, effector and parameters)
+    void write (ostream& os) const;
+    void read (istream& is);
+
 };
 
 
+/*
+ *    ###  #   #  #####  #####   ####  ####     #    #####  #####
+ *     #   ##  #    #    #      #      #   #   # #     #    #
+ *     #   # # #    #    ####   #  ##  ####   #####    #    ####
+ *     #   #  ##    #    #      #   #  #  #   #   #    #    #
+ *    ###  #   #    #    #####   ###   #   #  #   #    #    #####
+ */
+
+//
+//  The parameters are copied to local constants and the step is written
+//  out, so that the whole loop is one kernel (also the observer is
+//  inlined). Since the effectors are constant, each production rate is
+//
+//      alpha Hill(k prod_j r_j^2) = alpha k / (k + (prod_j 1/r_j)^2)
+//
+//  with k = K_Pol C_Pol G(h) (from the plan) and r_j the repressions: one
+//  division per gene
+//  instead of one per factor, and the step is x (1 - delta dt) + alpha k dt /
+//  (...), with the constants folded (the states agree with those of evolve
+//  to rounding). The gaussian numbers are drawn in blocks, in the same sequence
+//  as evolve (redraws included), and never beyond the last step: the state
+//  of ranlxd is saved before each block, and if the observer stops the
+//  integration it is restored and only the numbers used are drawn again, so
+//  that the generator is where a loop of evolve would leave it.
+//
+#define PONI_BLOCK 64
+
+template <class Obs>
+long PONI::integrate (long nsteps, double dt, bool stoch, Obs observer)
+{
+    const double kPax = plan.kPax, kOli = plan.kOli;
+    const double kNkx = plan.kNkx, kIrx = plan.kIrx;
+    const double aPax = alpha_Pax * kPax * dt, aOli = alpha_Oli * kOli * dt;
+    const double aNkx = alpha_Nkx * kNkx * dt, aIrx = alpha_Irx * kIrx * dt;
+    const double kOP = K_Oli_Pax, kNP = K_Nkx_Pax, kNO = K_Nkx_Oli, kIO = K_Irx_Oli;
+    const double kPN = K_Pax_Nkx, kON = K_Oli_Nkx, kIN = K_Irx_Nkx;
+    const double kOI = K_Oli_Irx, kNI = K_Nkx_Irx;
+    const double d = delta, c = 1. - delta * dt, sq = sqrt(dt/Omega);
+
+    double x0 = x(0), x1 = x(1), x2 = x(2), x3 = x(3);
+    double g[4*PONI_BLOCK];
+    int ng = 0, ig = 0;     // numbers in the block, next one
+    int rs[105];            // state of ranlxd before the block (rlxd_size())
+
+    long k;
+    for (k = 1; k <= nsteps; k++)
+    {
+        // production over a step (rate times dt)
+        double dP = (1. + kOP * x1) * (1. + kNP * x2);
+        double dO = (1. + kNO * x2) * (1. + kIO * x3);
+        double dN = (1. + kPN * x0) * (1. + kON * x1) * (1. + kIN * x3);
+        double dI = (1. + kOI * x1) * (1. + kNI * x2);
+        double p0 = aPax / (kPax + dP * dP);
+        double p1 = aOli / (kOli + dO * dO);
+        double p2 = aNkx / (kNkx + dN * dN);
+        double p3 = aIrx / (kIrx + dI * dI);
+
+        double y0 = c * x0 + p0;
+        double y1 = c * x1 + p1;
+        double y2 = c * x2 + p2;
+        double y3 = c * x3 + p3;
+
+        if (stoch)
+        {
+            double s0 = sqrt(p0/dt + d * x0), s1 = sqrt(p1/dt + d * x1);
+            double s2 = sqrt(p2/dt + d * x2), s3 = sqrt(p3/dt + d * x3);
+            double z0, z1, z2, z3;
+            STATS_ADD(redraws, -1);     // the first draw is not a redraw
+            do {
+                STATS_ADD(redraws, 1);
+                if (ig == ng)
+                {
+                    ng = 4 * (int) min((long) PONI_BLOCK, nsteps - k + 1);
+                    ranlxd(g, 0);   // initializes the generator if needed
+                    rlxd_get(rs);
+                    gauss_dble(g, ng);
+                    ig = 0;
+                }
+                z0 = y0 + sq * (s0 * g[ig]);
+                z1 = y1 + sq * (s1 * g[ig+1]);
+                z2 = y2 + sq * (s2 * g[ig+2]);
+                z3 = y3 + sq * (s3 * g[ig+3]);
+                ig += 4;
+            } while ((z0 < 0.) || (z1 < 0.) || (z2 < 0.) || (z3 < 0.));
+            y0 = z0, y1 = z1, y2 = z2, y3 = z3;
+        }
+
+        x0 = y0, x1 = y1, x2 = y2, x3 = y3;
+        if (!observer(k, PONI_x_t(x0, x1, x2, x3)))
+        {
+            if (ig < ng)
+            {
+                rlxd_reset(rs);
+                gauss_dble(g, ig);
+            }
+            break;
+        }
+    }
+    if (k > nsteps)
+        k = nsteps;
+
+    STATS_ADD(steps, k);
+    STATS_ADD(prodR, k);
+    x << x0, x1, x2, x3;
+    return k;
+}
+
+inline long PONI::integrate (long nsteps, double dt, bool stoch)
+{
+    return integrate(nsteps, dt, stoch, [](long, const PONI_x_t&) { return true; });
+}
+
+
 #endif
\ No newline at end of file
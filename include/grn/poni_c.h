@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ *  poni_c.h
+ *
+ *  C interface of libponi.so (batches of PONI cells, see grn/batch.h), for
+ *  callers in other languages (ctypes, Julia ccall, C/C++ services).
+ *
+ *  Handles are opaque. Functions returning int give PONI_OK or an error code
+ *  (no function of the interface exits the process). Arrays are passed as
+ *  pointers to doubles in structure of arrays form:
+ *
+ *    state       x[k*n + i], k = Pax, Olig, Nkx, Irx  (4 x n)
+ *    effectors   h[k*n + i], k = GliA, GliR           (2 x n)
+ *
+ *  A state array given to poni_batch_new is owned by the caller and evolved
+ *  in place (it must outlive the batch); with NULL the batch allocates it,
+ *  and poni_batch_state returns it.
+ *
+ *  Stochastic steps draw from ranlxdv (and ranlxd), whose state is private
+ *  to each thread: call poni_seed on each thread that advances batches.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef PONI_C_H
+#define PONI_C_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+#define PONI_ABI_VERSION 1
+
+#define PONI_OK       0
+#define PONI_EINVAL   1     /* invalid argument or parameter name */
+#define PONI_EIO      2     /* file not readable */
+#define PONI_EFAIL    3     /* internal failure (e.g. out of memory) */
+
+#define PONI_SCHEDULE_CONSTANT 0
+#define PONI_SCHEDULE_LINEAR   1
+#define PONI_SCHEDULE_SPLINE   2
+
+typedef struct poni_params poni_params;
+typedef struct poni_batch poni_batch;
+typedef struct poni_schedule poni_schedule;
+
+#ifndef PONI_C_CC
+extern int poni_abi_version(void);
+extern void poni_seed(int seed);
+
+/* parameter sets (defaults of the PONI class, names as in the files) */
+extern poni_params *poni_params_new(void);
+extern void poni_params_free(poni_params *p);
+extern int poni_params_load(poni_params *p,const char *filename);
+extern int poni_params_set(poni_params *p,const char *name,double value);
+extern int poni_params_get(const poni_params *p,const char *name,double *value);
+
+/* batches of n cells (the parameters are copied) */
+extern poni_batch *poni_batch_new(const poni_params *p,int n,double *state);
+extern void poni_batch_free(poni_batch *b);
+extern int poni_batch_size(const poni_batch *b);
+extern double *poni_batch_state(poni_batch *b);
+extern int poni_batch_set_effector(poni_batch *b,double gliA,double gliR);
+extern int poni_batch_set_effectors(poni_batch *b,const double *h);
+/* one value per cell of a parameter (n values, units of the files) */
+extern int poni_batch_set_parameters(poni_batch *b,const char *name,
+                                     const double *values);
+extern int poni_batch_advance(poni_batch *b,double T,double dt,int stochastic);
+/* delays of the production of the 4 genes (multiples of the step dt) */
+extern int poni_batch_set_delays(poni_batch *b,const double *tau,double dt);
+extern int poni_batch_read_state(const poni_batch *b,double *x);
+extern int poni_batch_write_state(poni_batch *b,const double *x);
+
+/* schedules of the effectors (see grn/schedule.h): m knots t[j] with
+   effectors h[k*m + j] (k = GliA, GliR), or a file of lines "t GliA GliR" */
+extern poni_schedule *poni_schedule_new(const double *t,const double *h,int m,
+                                        int interpolation);
+extern poni_schedule *poni_schedule_load(const char *filename,int interpolation);
+extern void poni_schedule_free(poni_schedule *s);
+extern int poni_batch_advance_schedule(poni_batch *b,const poni_schedule *s,
+                                       double t0,double T,double dt,int stochastic);
+#endif
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ *  response.h
+ *
+ *  Response of a PONI cell to a constant level of Gli: table of the final
+ *  state reached from a common initial condition (the prepattern) after a
+ *  time T, as a function of g = GliA (GliR = 1 - g).
+ *
+ *  The table is built on a grid uniform in log(g), refined by bisection
+ *  wherever neighbouring entries differ by more than 'tol' (in any gene),
+ *  down to intervals of width 'dlogMin'. Each entry is flagged as bistable
+ *  when the state reached from the ventral end (g = gMax) is different.
+ *  Lookups interpolate linearly in log(g), except across jumps (domain
+ *  boundaries), where the nearest entry is taken.
+ *
+ *  Binary format of the cache (native byte order):
+ *
+ *    char[8]   "PONIRSP1"
+ *    int       length of the key, followed by the key:
+ *                double T, dt, gMin, gMax, tol, dlogMin; int n0;
+ *                double state[4], effector[2] of the initial cell and its
+ *                parameters, in the order of PONI::parameterNames()
+ *    int       number of entries, followed by g, x[4], bistable (char) each
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef RESPONSE_H
+#define RESPONSE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "grn/poni.h"
+
+using namespace std;
+
+
+class ResponseTable {
+
+private:
+
+    string key;                 // serialized initial cell and settings
+
+    PONI_x_t reach (const PONI& start, double g) const;
+    int entry (const PONI& start, const PONI& ventral, double g);
+    bool differ (int i, int j) const;
+    void refine (const PONI& start, const PONI& ventral, int i, int j);
+    string makeKey (const PONI& start) const;
+
+public:
+
+    double T;           // time of evolution of each cell
+    double dt;
+    double gMin, gMax;  // range of g (clamped outside)
+    int n0;             // intervals of the initial grid
+    double tol;         // refine if neighbours differ by more than tol
+    double dlogMin;     // smallest interval in log(g)
+
+    vector<double> g;
+    vector<PONI_x_t, aligned_allocator<PONI_x_t>> x;
+    vector<char> bistable;
+
+    ResponseTable ();
+
+    // build the table for cells starting as 'start' (deterministic evolution)
+    void build (const PONI& start);
+
+    // final state for the level g
+    PONI_x_t lookup (double g, bool* bist = NULL) const;
+
+    // the cache is used only if it was built with the same initial cell
+    // and settings; returns false otherwise
+    bool load (const char* filename, const PONI& start);
+    void save (const char* filename) const;
+};
+
+
+#endif
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  schedule.h
+ *
+ *  Time course of the effectors (GliA, GliR) of a PONI cell or batch, given
+ *  at knots t_0 < ... < t_m and interpolated between them:
+ *
+ *    SCHEDULE_CONSTANT   piecewise constant (value of the last knot)
+ *    SCHEDULE_LINEAR     linear
+ *    SCHEDULE_SPLINE     natural cubic spline
+ *
+ *  Before t_0 and after t_m the effectors are those of the first and last
+ *  knot. Schedules are built from arrays or read from a file with lines
+ *  "t GliA GliR" (lines starting with # are skipped).
+ *
+ *  The integrators (PONI::integrate and PONIbatch::advance with a schedule)
+ *  go through the schedule segment by segment: on segments where the
+ *  effectors are constant the plan is built once and the whole segment runs
+ *  in the fused kernel, elsewhere the effectors are set at the beginning of
+ *  each step.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+#define SCHEDULE_CONSTANT 0
+#define SCHEDULE_LINEAR 1
+#define SCHEDULE_SPLINE 2
+
+typedef vector<PONI_h_t, aligned_allocator<PONI_h_t>> SCHEDULE_h_t;
+
+
+class Schedule {
+
+private:
+
+    int mode;
+    vector<double> t;       // knots
+    SCHEDULE_h_t v;         // effectors at the knots
+    SCHEDULE_h_t b, c, d;   // h = v + b s + c s^2 + d s^3 on each segment
+    vector<char> flat;      // segments with constant effectors
+
+    void build ();
+
+public:
+
+    Schedule (const vector<double>& times, const SCHEDULE_h_t& values,
+              int interpolation = SCHEDULE_LINEAR);
+    Schedule (const char* filename, int interpolation = SCHEDULE_LINEAR);
+
+    PONI_h_t at (double time) const;
+
+    // segments: -1 before t_0, i on [t_i, t_i+1), m after t_m
+    int segment (double time) const;
+    double segmentEnd (int seg) const;
+    bool constant (int seg) const;
+
+    // number of steps from step k (starting at t0 + k dt) which start in
+    // the same segment, if this is constant (LONG_MAX after t_m), otherwise 1
+    long stepsInSegment (double t0, double dt, long k) const;
+};
+
+
+/*
+ *    ###  #   #  #####  #####   ####  ####     #    #####  #####
+ *     #   ##  #    #    #      #      #   #   # #     #    #
+ *     #   # # #    #    ####   #  ##  ####   #####    #    ####
+ *     #   #  ##    #    #      #   #  #  #   #   #    #    #
+ *    ###  #   #    #    #####   ###   #   #  #   #    #    #####
+ */
+
+//
+//  nsteps steps from time t0 with the effectors of the schedule at the
+//  beginning of each step; on constant segments all the steps that start in
+//  the segment are one call of the kernel
+//
+template <class Obs>
+long PONI::integrate (long nsteps, double dt, bool stoch, const Schedule& s,
+                      double t0, Obs observer)
+{
+    long k = 0;
+    while (k < nsteps)
+    {
+        setEffector(s.at(t0 + k*dt));
+        long m = min(s.stepsInSegment(t0, dt, k), nsteps - k);
+
+        long done = integrate(m, dt, stoch, [&](long j, const PONI_x_t& x) {
+            return observer(k + j, x);
+        });
+        k += done;
+        if (done < m)
+            break;
+    }
+    return k;
+}
+
+inline long PONI::integrate (long nsteps, double dt, bool stoch, const Schedule& s,
+                             double t0)
+{
+    return integrate(nsteps, dt, stoch, s, t0, [](long, const PONI_x_t&) { return true; });
+}
+
+
+#endif
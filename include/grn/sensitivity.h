@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ *  sensitivity.h
+ *
+ *  Derivatives of the final state of a deterministic PONI trajectory with
+ *  respect to the parameters (columns in the order of PONI::parameterNames)
+ *  and to the initial state.
+ *
+ *  Both methods differentiate the Euler map of PONI::evolve exactly, so the
+ *  results are the derivatives of the discrete trajectory:
+ *
+ *  - forward sensitivities, S = dx/dp, integrated along the trajectory
+ *    (S <- S + dt (J S + dF/dp)), cost of 4 x PONI_NPAR extra variables;
+ *
+ *  - discrete adjoint, the gradient of a function of the final state,
+ *    lambda <- lambda + dt J^T lambda backwards along the stored trajectory,
+ *    at the cost of one extra (backward) solve for all the parameters.
+ *
+ *  Phases with different effectors (e.g. prepattern and pattern) are chained
+ *  by passing the sensitivities (forward), or the adjoint at the beginning of
+ *  the following phase (adjoint), from one call to the next.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include <functional>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+// loss as a function of the final state, returning its gradient in 'grad'
+typedef function<double(const PONI_x_t& x, PONI_x_t& grad)> PONI_loss_t;
+
+typedef Matrix<double,1,PONI_NPAR> PONI_g_t;  // gradient w.r.t. parameters
+
+
+// evolve 'cell' (deterministically) for a time T and update the
+// sensitivities S of its state (zero if the initial state does not depend
+// on the parameters)
+void forwardSensitivity (PONI& cell, double T, double dt, PONI_P_t& S);
+
+// gradient w.r.t. the parameters of lambdaT . x(T), for the trajectory
+// starting from 'cell' (which is not changed); the adjoint at the initial
+// time, d(lambdaT . x(T))/dx(0), is returned in lambda0 if not NULL
+PONI_g_t adjointGradient (const PONI& cell, double T, double dt,
+                          const PONI_x_t& lambdaT, PONI_x_t* lambda0 = NULL);
+
+// gradient of loss(x(T)); the value of the loss is returned in 'value'
+PONI_g_t adjointGradient (const PONI& cell, double T, double dt,
+                          PONI_loss_t loss, double* value = NULL,
+                          PONI_x_t* lambda0 = NULL);
+
+
+#endif
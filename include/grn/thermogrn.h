@@ -0,0 +1,585 @@
+/******************************************************************************
+ *
+ *  thermogrn.h
+ *
+ *  Generic thermodynamic GRN with compile-time topology.
+ *
+ *  The network is described by a class (see grn/networks.h) providing
+ *
+ *    static const int N, M;                number of genes and effectors
+ *    static constexpr int coop (i, j);     cooperativity of repression of
+ *                                          gene i by gene j (0: no binding)
+ *    static constexpr bool target (i);     gene i is bound by the effectors
+ *    static constexpr bool activating (k); effector k recruits RNA-polymerase
+ *    static const char* name (i);          name of gene i (parameter keys)
+ *    static PAR_dict defaults ();          default parameter values
+ *
+ *  Production of gene i is
+ *
+ *    alpha_i * Hill( K_Pol_i C_Pol * G_i(h) * prod_j (1 + K_j_i x_j)^-coop(i,j) )
+ *
+ *  with G_i(h) = (1 + f_A K_Gli_i h_act)/(1 + K_Gli_i h_tot) for targets of
+ *  the effectors.  All loops over genes and regulators are unrolled at compile
+ *  time, so each instantiation produces a fixed-size kernel equivalent to a
+ *  hand-written one (ThermoGRN<PONInet> reproduces the PONI class exactly).
+ *
+ *  The kernels are evaluated in precision Real and the state is accumulated
+ *  in precision Acc (default: Real).  With Real = float the noise is drawn
+ *  from ranlxs (as in gauss(), transformed in single precision), which must
+ *  then be initialized (rlxs_init or start_ranlux).  ThermoGRN<Net,float,
+ *  double> is the mixed-precision mode.
+ *
+ *  ThermoBatch<Net,Real,Acc> evolves an ensemble of cells of one ThermoGRN
+ *  (same parameters and effectors), stored as structure of arrays,
+ *  x[k*n + i] (gene k of cell i).  The production and the drift of all the
+ *  cells are computed in one loop over the cells, which the compiler
+ *  vectorizes (twice as many cells per instruction in single precision),
+ *  and the noise in a second loop; the gaussian numbers of a step are drawn
+ *  in one block, those of the redraws cell by cell.  Deterministic steps are
+ *  identical to those of ThermoGRN::evolve.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#ifndef THERMOGRN_H
+#define THERMOGRN_H
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Dense>
+#include "random.h"
+#include "stats.h"
+
+using namespace std;
+using namespace Eigen;
+
+#ifndef NET_TYPE_DEFS
+#define NET_TYPE_DEFS
+typedef unordered_map<string,int> NET_dict;
+typedef unordered_map<string,double> PAR_dict;
+#endif
+
+
+//
+//  Compile-time helpers (unrolled kernels)
+//
+
+// r^C
+template <int C>
+struct GRNpow {
+    template <class R>
+    static inline R of (R r) { return r * GRNpow<C-1>::of(r); }
+};
+
+template <>
+struct GRNpow<1> {
+    template <class R>
+    static inline R of (R r) { return r; }
+};
+
+// repression of gene I by genes J, J+1, ..., N-1 (C = -1 ends the recursion)
+template <class Net, int I, int J, int C = (J < Net::N ? Net::coop(I,J) : -1)>
+struct GRNrepression {
+    template <class R, class KM, class XV>
+    static inline R apply (R z, const KM& K, const XV& x)
+    {
+        R r = R(1)/(R(1) + K(I,J) * R(x(J)));
+        return GRNrepression<Net,I,J+1>::apply(z * GRNpow<C>::of(r), K, x);
+    }
+};
+
+template <class Net, int I, int J>
+struct GRNrepression<Net,I,J,0> {
+    template <class R, class KM, class XV>
+    static inline R apply (R z, const KM& K, const XV& x)
+    {
+        return GRNrepression<Net,I,J+1>::apply(z, K, x);
+    }
+};
+
+template <class Net, int I, int J>
+struct GRNrepression<Net,I,J,-1> {
+    template <class R, class KM, class XV>
+    static inline R apply (R z, const KM&, const XV&) { return z; }
+};
+
+// activation by the effectors (only for targets)
+template <class Net, int I, bool T = Net::target(I)>
+struct GRNactivation {
+    template <class R>
+    static inline R apply (R z, R f_A, R K, R hA, R hT)
+    {
+        R aux = R(1) + f_A * K * hA;
+        aux /= R(1) + K * hT;
+        return z * aux;
+    }
+};
+
+template <class Net, int I>
+struct GRNactivation<Net,I,false> {
+    template <class R>
+    static inline R apply (R z, R, R, R, R) { return z; }
+};
+
+// production of genes I, I+1, ..., N-1
+template <class Net, int I = 0, bool END = (I == Net::N)>
+struct GRNproduction {
+    template <class G, class R>
+    static inline void apply (G& g, R hA, R hT)
+    {
+        R z = g.K_Pol(I) * g.C_Pol;
+        z = GRNactivation<Net,I>::apply(z, g.f_A, g.K_Gli(I), hA, hT);
+        z = GRNrepression<Net,I,0>::apply(z, g.K, g.x);
+        g.prodR(I) = g.alpha(I) * z/(R(1) + z);
+        GRNproduction<Net,I+1>::apply(g, hA, hT);
+    }
+};
+
+template <class Net, int I>
+struct GRNproduction<Net,I,true> {
+    template <class G, class R>
+    static inline void apply (G&, R, R) {}
+};
+
+// gaussian noise in the precision of the kernel
+template <class R>
+struct GRNgauss;
+
+template <>
+struct GRNgauss<double> {
+    static inline void draw (double* g, int n) { gauss_dble(g,n); }
+};
+
+// numbers of ranlxs with the transformation of gauss() (Box-Muller) done in
+// single precision, in about half the time of that in double precision
+template <>
+struct GRNgauss<float> {
+    static inline void draw (float* g, int n)
+    {
+        const float twoPi = float(2.*3.141592653589793), sq2 = float(sqrt(2.));
+        float u[2];
+        for (int k = 0; k < n; )
+        {
+            ranlxs(u,2);
+            float rho = sqrtf(-logf(1.f - u[0]));
+            float x2 = u[1] * twoPi;
+            g[k++] = sq2 * rho * sinf(x2);
+            if (k < n)
+                g[k++] = sq2 * rho * cosf(x2);
+        }
+    }
+};
+
+// production of genes I, I+1, ..., N-1 of a cell of ThermoBatch, with the
+// factors of RNA-polymerase and of the effectors folded in kP
+template <class Net, int I = 0, bool END = (I == Net::N)>
+struct GRNcolumn {
+    template <class R, class KM, class XV>
+    static inline void apply (R* r, const R* kP, const R* alpha, const KM& K,
+                              const XV& x)
+    {
+        R z = GRNrepression<Net,I,0>::apply(kP[I], K, x);
+        r[I] = alpha[I] * z/(R(1) + z);
+        GRNcolumn<Net,I+1>::apply(r, kP, alpha, K, x);
+    }
+};
+
+template <class Net, int I>
+struct GRNcolumn<Net,I,true> {
+    template <class R, class KM, class XV>
+    static inline void apply (R*, const R*, const R*, const KM&, const XV&) {}
+};
+
+template <class, class, class> class ThermoBatch;
+
+
+template <class Net, class Real = double, class Acc = Real>
+class ThermoGRN {
+
+public:
+
+    static const int N = Net::N;
+    static const int M = Net::M;
+
+    typedef Matrix<Acc,N,1> x_t;     // type of state variable
+    typedef Matrix<Real,M,1> h_t;    // type of effector variable
+    typedef Matrix<Real,N,1> r_t;    // type of rates (kernel precision)
+
+private:
+
+    template <class, int, bool> friend struct GRNproduction;
+    template <class, class, class> friend class ThermoBatch;
+
+    PAR_dict pars;  // dictionary containing parameters (keys are names)
+
+    double lambdaConc;
+    double lambdaTime;
+
+    r_t K_Pol;              // affinities of RNA-polymerase
+    r_t K_Gli;              // affinities of the effectors
+    Matrix<Real,N,N> K;     // K(i,j): affinity of gene j onto gene i
+    Real f_A;               // activator -- RNAp binding cooperativity
+    Real C_Pol;             // concentration RNA-polymerase
+    r_t alpha;              // coefficient production rate
+    Real delta;             // degradation rate
+    Real Omega;             // "protein copy number" (inverse noise strength)
+
+    x_t x;    // state variables
+    h_t h;    // control/effector variables
+
+    r_t prodR;  // probability of RNA-polimerase bound
+    r_t drift;
+    r_t noise;
+
+    static string key (const char* pre, int i)
+    {
+        return string(pre) + Net::name(i);
+    }
+
+    static string key (int j, int i)
+    {
+        return string("K_") + Net::name(j) + "_" + Net::name(i);
+    }
+
+    double parameter (const string& k)
+    {
+        auto it = pars.find(k);
+        if (it == pars.end())
+        {
+            cout << "error: ThermoGRN: missing default for parameter \""
+                 << k << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        return it->second;
+    }
+
+    void assignParameters ()
+    {
+        lambdaConc = parameter("lambdaConc");
+        lambdaTime = parameter("lambdaTime");
+        K.setZero();
+        K_Gli.setZero();
+        for (int i = 0; i < N; i++)
+        {
+            K_Pol(i) = Real(parameter(key("K_Pol_", i)) / lambdaConc);
+            alpha(i) = Real(parameter(key("alpha_", i)) * lambdaConc / lambdaTime);
+            if (Net::target(i))
+                K_Gli(i) = Real(parameter(key("K_Gli_", i)) / lambdaConc);
+            for (int j = 0; j < N; j++)
+                if (Net::coop(i,j) > 0)
+                    K(i,j) = Real(parameter(key(j,i)) / lambdaConc);
+        }
+        f_A   = Real(parameter("f_A"));
+        C_Pol = Real(parameter("C_Pol") * lambdaConc);
+        delta = Real(parameter("delta") / lambdaTime);
+        Omega = Real(parameter("Omega"));
+    }
+
+    void setProdR ()
+    {
+        STATS_ADD(prodR,1);
+        Real hA = 0., hT = 0.;
+        for (int k = 0; k < M; k++)
+        {
+            if (Net::activating(k))
+                hA += h(k);
+            hT += h(k);
+        }
+        GRNproduction<Net>::apply(*this, hA, hT);
+    }
+
+    void setDrift ()
+    {
+        setProdR();
+        drift = prodR - delta * x.template cast<Real>();
+    }
+
+    void setNoise ()
+    {
+        Real g[N];
+        GRNgauss<Real>::draw(g,N);
+        for (int i = 0; i < N; i++)
+            noise(i) = sqrt(prodR(i) + delta * Real(x(i)))*g[i];
+    }
+
+public:
+
+    // contructors
+    ThermoGRN () : pars(Net::defaults())
+    {
+        x.setZero();
+        h.setZero();
+        assignParameters();
+    }
+
+    ThermoGRN (x_t vec) : ThermoGRN()  { x = vec; }
+    ThermoGRN (x_t vec, h_t eff) : ThermoGRN() { x = vec; h = eff; }
+
+    //  Set one parameter through its key (string)
+    void setParameters (string k, double val)
+    {
+        auto it = pars.find(k);
+        if(it != pars.end())
+            it->second = val;
+        else
+        {
+            cout << "error: setParameters (ThermoGRN): invalid parameter name \""
+                 << k << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        assignParameters();
+    }
+
+    //  Set a number of parameters contained into a file in "key  value" form
+    void setParameters (const char* filename)
+    {
+        ifstream parf(filename);
+        string k;
+        double val;
+        while (parf >> k >> val)
+        {
+            auto it = pars.find(k);
+            if(it != pars.end())
+                it->second = val;
+            else
+            {
+                cout << "error: setParameters: invalid parameter name in \""
+                     << filename << "\":  " << k << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        parf.close();
+        assignParameters();
+    }
+
+    void testParameters (const char* filename)
+    {
+        ofstream os(filename, ios::out);
+        testParameters(os);
+        os.close();
+    }
+
+    void testParameters (ostream& os)
+    {
+        os << "# thermodynamic GRN parameters\n";
+        for( const auto& n : pars )
+            os << n.first << "\t\t" << n.second << "\n";
+        os << "\n";
+    }
+
+    void setState (x_t vec) { x = vec; }
+    void setEffector (h_t eff) { h = eff; }
+
+    x_t getState () const { return x; }
+    h_t getEffector () const { return h; }
+
+    r_t getDrift () { setDrift(); return drift; }
+    r_t getProdR () { setProdR(); return prodR; }
+
+    friend ostream& operator<< (ostream& os, const ThermoGRN& g)
+    {
+        os << (g.x).transpose() << "\t" << (g.h).transpose();
+        return os;
+    }
+
+    // the increment is computed in the kernel precision (Real),
+    // and added to the state in the accumulation precision (Acc)
+    void evolve (double dt, bool stoch)
+    {
+        x_t xp, xpp;
+
+        STATS_ADD(steps,1);
+        setDrift();       // this also sets the necessary variables for noise
+        xpp = x + (drift * Real(dt)).template cast<Acc>();
+        xp = xpp;
+        if (stoch) {
+            const Real s = sqrt(Real(dt)/Omega);
+            STATS_ADD(redraws,-1);   // the first draw is not a redraw
+            do {
+                STATS_ADD(redraws,1);
+                setNoise();
+                xp = xpp + (s * noise).template cast<Acc>();
+            } while ( (xp.array() < Acc(0)).any() );
+        }
+        x = xp;
+    }
+
+};
+
+
+template <class Net, class Real = double, class Acc = Real>
+class ThermoBatch {
+
+public:
+
+    static const int N = Net::N;
+
+    typedef ThermoGRN<Net,Real,Acc> cell_t;
+    typedef typename cell_t::x_t x_t;
+    typedef typename cell_t::h_t h_t;
+
+private:
+
+    cell_t par;         // parameters and effectors
+    int n;
+    vector<Acc> x;      // states, N x n
+    vector<Acc> xd;     // deterministic part of a step
+    vector<Real> rp;    // production rates of a step
+    vector<Real> g;     // gaussian numbers of a step
+    Real kP[N];         // K_Pol C_Pol G(h) of each gene
+    Real alpha[N];
+
+    // state of cell i, gene j (for the unrolled kernels)
+    struct column {
+        const Acc* const* x;
+        int i;
+        Acc operator() (int j) const { return x[j][i]; }
+    };
+
+    // factors of the production that depend on the effectors, in the order
+    // of the operations of ThermoGRN::setProdR
+    void makePlan ()
+    {
+        Real hA = 0., hT = 0.;
+        for (int k = 0; k < cell_t::M; k++)
+        {
+            if (Net::activating(k))
+                hA += par.h(k);
+            hT += par.h(k);
+        }
+        for (int i = 0; i < N; i++)
+        {
+            Real z = par.K_Pol(i) * par.C_Pol;
+            if (Net::target(i))
+            {
+                Real aux = Real(1) + par.f_A * par.K_Gli(i) * hA;
+                aux /= Real(1) + par.K_Gli(i) * hT;
+                z = z * aux;
+            }
+            kP[i] = z;
+            alpha[i] = par.alpha(i);
+        }
+    }
+
+public:
+
+    // n cells in the state of the given one
+    ThermoBatch (const cell_t& cell, int size) : par(cell), n(size)
+    {
+        if (n < 1)
+        {
+            cout << "error: ThermoBatch: invalid number of cells\n";
+            exit(EXIT_FAILURE);
+        }
+        x.resize(N*n);
+        for (int i = 0; i < n; i++)
+            setState(i, cell.getState());
+        makePlan();
+    }
+
+    int size () const { return n; }
+
+    Acc* state () { return x.data(); }
+    const Acc* state () const { return x.data(); }
+
+    void setState (int i, const x_t& xi)
+    {
+        for (int k = 0; k < N; k++)
+            x[k*n + i] = xi(k);
+    }
+
+    x_t getState (int i) const
+    {
+        x_t xi;
+        for (int k = 0; k < N; k++)
+            xi(k) = x[k*n + i];
+        return xi;
+    }
+
+    void setEffector (const h_t& eff)
+    {
+        par.setEffector(eff);
+        makePlan();
+    }
+
+    void evolve (double dt, bool stoch)
+    {
+        const Real delta = par.delta, tau = Real(dt);
+
+        STATS_ADD(steps, n);
+        STATS_ADD(prodR, n);
+        xd.resize(N*n);
+        rp.resize(N*n);
+
+        // production and drift of all the cells (branchless, vectorized)
+        const Acc* xc[N];
+        Acc* yc[N];
+        Real* rc[N];
+        Real kc[N], ac[N];
+        for (int k = 0; k < N; k++)
+        {
+            xc[k] = x.data() + k*n;
+            yc[k] = xd.data() + k*n;
+            rc[k] = rp.data() + k*n;
+            kc[k] = kP[k];
+            ac[k] = alpha[k];
+        }
+        const Matrix<Real,N,N> K = par.K;
+#pragma GCC ivdep
+        for (int i = 0; i < n; i++)
+        {
+            Real r[N];
+            column xi = {xc, i};
+            GRNcolumn<Net>::apply(r, kc, ac, K, xi);
+            for (int k = 0; k < N; k++)
+            {
+                const Acc xk = xc[k][i];
+                yc[k][i] = xk + Acc((r[k] - delta * Real(xk)) * tau);
+                rc[k][i] = r[k];
+            }
+        }
+
+        if (!stoch)
+        {
+            x.swap(xd);
+            return;
+        }
+
+        // noise, with the redraws of the cells with negative levels
+        const Real s = sqrt(tau/par.Omega);
+        g.resize(N*n);
+        GRNgauss<Real>::draw(g.data(), N*n);
+        for (int i = 0; i < n; i++)
+        {
+            Real* gi = g.data() + N*i;
+            Real sd[N];
+            Acc xp[N];
+            for (int k = 0; k < N; k++)
+                sd[k] = sqrt(rc[k][i] + delta * Real(xc[k][i]));
+            for (;;)
+            {
+                bool neg = false;
+                for (int k = 0; k < N; k++)
+                {
+                    xp[k] = yc[k][i] + Acc(s * (sd[k] * gi[k]));
+                    neg |= xp[k] < Acc(0);
+                }
+                if (!neg)
+                    break;
+                STATS_ADD(redraws, 1);
+                GRNgauss<Real>::draw(gi, N);
+            }
+            for (int k = 0; k < N; k++)
+                x[k*n + i] = xp[k];
+        }
+    }
+};
+
+
+#endif
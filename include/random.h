@@ -23,9 +23,22 @@ extern void rlxd_get(int state[]);
 extern void rlxd_reset(int state[]);
 #endif
 
+#define RLXDV_MAX 64
+
+#ifndef RANLXDV_C
+extern void ranlxdv(double r[],int n);
+extern void rlxdv_init(int nstream,int level,int seed);
+extern int rlxdv_streams(void);
+extern const char *rlxdv_isa(void);
+extern int rlxdv_size(void);
+extern void rlxdv_get(int state[]);
+extern void rlxdv_reset(int state[]);
+#endif
+
 #ifndef GAUSS_C
 extern void gauss(float r[],int n);
 extern void gauss_dble(double r[],int n);
+extern void gauss_dblev(double r[],int n);
 extern double gaussdistr(double x);
 #endif
 
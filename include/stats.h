@@ -0,0 +1,60 @@
+
+/*******************************************************************************
+*
+* File stats.h
+*
+* Optional instrumentation of the hot paths: counters of steps, production
+* evaluations, noise redraws and random numbers, and timers of the phases of
+* a simulation.
+*
+* Everything is compiled only with -DPONI_STATS; otherwise the macros below
+* expand to nothing and there is no cost. The counters are global and are
+* incremented with relaxed atomic additions, so that they are exact also
+* when the steps are taken on several threads (batches, lattice tiles, MLMC
+* and FFS tasks).
+*
+*******************************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+enum stats_phase_t {STATS_PREPATTERN, STATS_PATTERN, STATS_OUTPUT, STATS_NPHASE};
+
+typedef struct
+{
+   long long steps;        /* integration steps */
+   long long prodR;        /* evaluations of the production rates */
+   long long redraws;      /* noise redraws in the rejection loop of evolve */
+   long long rng;          /* random numbers from ranlxs and ranlxd */
+   double time[STATS_NPHASE];
+   long long phaseSteps[STATS_NPHASE];
+} stats_t;
+
+#ifndef STATS_C
+extern stats_t poni_stats;
+extern void stats_start(int phase);
+extern void stats_stop(int phase);
+extern void stats_report(const char *program);
+#endif
+
+#ifdef __cplusplus
+	}
+#endif
+
+#ifdef PONI_STATS
+#define STATS_ADD(counter,n)  ((void)__atomic_fetch_add(&poni_stats.counter,(n),__ATOMIC_RELAXED))
+#define STATS_START(phase)    stats_start(phase)
+#define STATS_STOP(phase)     stats_stop(phase)
+#define STATS_REPORT(program) stats_report(program)
+#else
+#define STATS_ADD(counter,n)  ((void)0)
+#define STATS_START(phase)    ((void)0)
+#define STATS_STOP(phase)     ((void)0)
+#define STATS_REPORT(program) ((void)0)
+#endif
+
+#endif
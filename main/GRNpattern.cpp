@@ -0,0 +1,163 @@
+/******************************************************************************
+ *
+ *	GRNpattern
+ *	
+ *	Same as PONIpattern, for a network whose topology is read at run time
+ *	from a description file (see ../include/grn/netgrn.h).
+ *
+ *	Gives as output the final pattern (protein levels as function of space).
+ *
+ *	Usage:	./GRNpattern network file [parameter file] [--threads n]
+ *
+ *	The cells of the pattern evolve together as a batch (NetBatch), whose
+ *	production rates are evaluated over columns of cells by the plan of the
+ *	network, on 'n' threads.
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <cstring>
+#include <vector>
+#include "random.h"
+#include "stats.h"
+#include "grn/netgrn.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+//
+//	exponential gradient of effector (Gli)
+//
+VectorXd gliGradient(const double x)
+{
+	VectorXd gli(2);
+	double aux = exp(- x/0.15);
+	gli <<	aux, 1.- aux;
+	return gli;
+}
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization
+	const double dx = .002;	// lattice spacing
+
+	cout << fixed;
+	cout << setprecision(6);
+
+	bool noise = false;		// whether to include low copy-number noise
+
+	const char* netfile = NULL;		// description of the network
+	const char* parfile = NULL;		// file with parameters
+	int threads = 1;				// threads of the batch
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--threads") && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (netfile == NULL && argv[i][0] != '-')
+			netfile = argv[i];
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			netfile = NULL;
+			break;
+		}
+	}
+	if (netfile == NULL || threads < 1)
+	{
+		cout << "usage: " << argv[0] << " [network file] [parameter file (optional)] "
+			 << "[--threads n]\n";
+		return EXIT_FAILURE;
+	}
+
+	// initialize pseudo-random number generator
+	if (noise)
+	{
+		int seed = rlxd_seed();
+	    rlxd_init(1,seed);
+	}
+
+	// network topology, default parameters and initial conditions
+	// are read from the description file (e.g. network_PONI.dat)
+	NetGRN start(netfile);
+
+	if (start.effectorSize() != 2)
+	{
+		cout << "error: GRNpattern: the network must have two effectors (GliA, GliR)\n";
+		return EXIT_FAILURE;
+	}
+
+	// write to file the parameters
+	start.testParameters("parameters_TEST.dat");
+
+	// use second command line argument as filename with parameters
+	if (parfile != NULL) start.setParameters(parfile);
+
+	start.setParameters("Omega", 500.);
+
+
+	//
+	// STEADY STATE FOR PREDOMINANTLY REPRESSIVE INPUT (PREPATTERN CONDITION)
+	//
+	VectorXd gli(2);
+	gli <<	0.,		// GliA
+			1.;		// GliR
+	start.setEffector(gli);
+
+	STATS_START(STATS_PREPATTERN);
+	for (double t = -1000.; t < 0.; t += dt) {
+		start.evolve(dt, noise);
+	}
+	STATS_STOP(STATS_PREPATTERN);
+
+
+	//
+	// SIMULATION WITH GRADIENT OF GLI
+	//
+	STATS_START(STATS_PATTERN);
+
+	// positions of the cells, and as many steps as the loop over the time
+	vector<double> pos;
+	for (double x = 0.; x < 1.; x += dx)
+		pos.push_back(x);
+	long steps = 0;
+	for (double t = 0.; t < 300.; t += dt)
+		steps++;
+
+	NetBatch cells(start, pos.size());
+	cells.threads = threads;
+	for (unsigned c = 0; c < pos.size(); c++)
+		cells.setEffector(c, gliGradient(pos[c]));
+	cells.advance(steps*dt, dt, noise);
+
+	STATS_STOP(STATS_PATTERN);
+
+	// print final pattern to stdout
+	STATS_START(STATS_OUTPUT);
+	for (unsigned c = 0; c < pos.size(); c++)
+	{
+		NetGRN grn = start;
+		grn.setState(cells.getState(c));
+		grn.setEffector(gliGradient(pos[c]));
+		cout << pos[c] << "\t" << grn << "\n";
+	}
+	cout.flush();
+	STATS_STOP(STATS_OUTPUT);
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("GRNpattern");
+
+	return 0;
+
+}
@@ -6,6 +6,19 @@
  *
  *	Gives as output the time evolution of protein levels.
  *
+ *	Usage:	./PONI [parameter file] [--checkpoint file [--interval steps]]
+ *				   [--resume file] [--parareal threads]
+ *
+ *	With --checkpoint, the full state of the simulation (including the
+ *	random number generator) is saved every 'interval' steps (default 10^6).
+ *	With --resume, the simulation continues exactly from a checkpoint and
+ *	prints only the lines after it (their number in the previous output is
+ *	reported on stderr).
+ *
+ *	With --parareal, the (deterministic) prepattern is integrated in parallel
+ *	in time on the given threads (see ../include/grn/parareal.h), up to
+ *	differences well below the precision of the output.
+ *
  *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
  *
  *****************************************************************************/
@@ -15,8 +28,12 @@
 #include <iostream>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include "random.h"
+#include "stats.h"
 #include "grn/poni.h"
+#include "grn/checkpoint.h"
+#include "grn/parareal.h"
 
 using namespace Eigen;
 using namespace std;
@@ -29,6 +46,39 @@ int main (int argc, char *argv[])
 
 	bool noise = false;		// whether to include low copy-number noise
 
+	const char* parfile = NULL;		// file with parameters
+	const char* ckfile = NULL;		// file where checkpoints are written
+	const char* resume = NULL;		// checkpoint to resume from
+	long interval = 1000000;		// steps between checkpoints
+	int parareal = 0;				// threads of the parallel prepattern
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--checkpoint") && i+1 < argc)
+			ckfile = argv[++i];
+		else if (!strcmp(argv[i], "--interval") && i+1 < argc)
+			interval = atol(argv[++i]);
+		else if (!strcmp(argv[i], "--resume") && i+1 < argc)
+			resume = argv[++i];
+		else if (!strcmp(argv[i], "--parareal") && i+1 < argc)
+			parareal = atoi(argv[++i]);
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] "
+				 << "[--checkpoint file [--interval steps]] [--resume file] "
+				 << "[--parareal threads]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (interval < 1) interval = 1;
+	if (parareal != 0 && (parareal < 1 || noise || ckfile != NULL || resume != NULL))
+	{
+		cout << "error: PONI: --parareal needs threads, no noise and no checkpoints\n";
+		return EXIT_FAILURE;
+	}
+
 	// initialize pseudo-random number generator
 	if (noise)
 	{
@@ -55,7 +105,7 @@ int main (int argc, char *argv[])
 	// use first command line argument as filename with parameters
 	// if none is passed, the default are used
 	// (the file may contain only a subset of the parameters, others are set to default)
-	if (argc == 2) grn.setParameters(argv[1]);
+	if (parfile != NULL) grn.setParameters(parfile);
 
 	// possible to set parameters individually by name
 	// e.g. parameter for strength of the noise (system size)
@@ -74,43 +124,115 @@ int main (int argc, char *argv[])
 
 
 	//
-	// STEADY STATE FOR PREDOMINANTLY REPRESSIVE INPUT
+	// CHECKPOINTS
 	//
+	// phase 0: steady state with repressive input, phase 1: activating input
+	// (state, parameters and generator are all restored from the checkpoint)
 
-	// set Gli input (constant)
-	gliVec <<	0.,		// GliA
-				1.;		// GliR
-	grn.setEffector(gliVec);
+	Checkpoint ck;
+	ck.rng = noise;
+	double t = -1000.;
 
-	// simulate system for long time
-	for (double t = -1000.; t < 0.; t += dt) {
-
-		// evolve by a step dt (Euler integration)
-		// set second variable to 'true' to add noise
-		grn.evolve(dt, noise);
-
-		// uncomment below to print trajectory to stdout
-		// cout << t << "\t" << grn << "\n";
+	if (resume != NULL)
+	{
+		ck.read(resume);
+		grn = ck.cells[0];
+		t = ck.t;
+		cerr << "resuming from \"" << resume << "\" (phase " << ck.phase
+			 << ", t = " << t << "): keep the first " << ck.lines
+			 << " lines of the previous output\n";
 	}
 
+	// save the simulation, which continues at time t
+	auto checkpoint = [&]() {
+		ck.t = t;
+		ck.cells.assign(1, grn);
+		ck.write(ckfile);
+	};
+
+	// evolve by steps dt while t < tend (Euler integration, with noise if
+	// 'noise' is true) in the fused kernel PONI::integrate: the observer
+	// advances t, prints the trajectory with 'print', and stops the kernel
+	// when a checkpoint is due, which is written between the steps
+	auto run = [&](double tend, bool print) {
+		long n = 0;
+		for (double s = t; s < tend; s += dt)
+			n++;
+
+		const PONI_h_t h = grn.getEffector();
+		while (n > 0)
+		{
+			bool save = false;
+			n -= grn.integrate(n, dt, noise, [&](long, const PONI_x_t& xs) {
+				if (print)
+				{
+					cout << t << "\t" << xs.transpose() << "\t" << h.transpose() << "\n";
+					ck.lines++;
+				}
+				t += dt;
+				ck.step++;
+				save = (ckfile != NULL && ck.step % interval == 0);
+				return !save;
+			});
+			if (save)
+				checkpoint();
+		}
+	};
+
 
 	//
-	// SIMULATION WITH PREDOMINANTLY ACTIVATING INPUT
+	// STEADY STATE FOR PREDOMINANTLY REPRESSIVE INPUT
 	//
 
-	gliVec <<	1.,		// GliA
-				0.;		// GliR
-	grn.setEffector(gliVec);
-	for (double t = 0.; t < 100.; t += dt) {
+	if (ck.phase == 0)
+	{
+		// set Gli input (constant)
+		gliVec <<	0.,		// GliA
+					1.;		// GliR
+		grn.setEffector(gliVec);
+
+		// simulate system for long time
+		STATS_START(STATS_PREPATTERN);
+		if (parareal > 0)
+		{
+			// as many steps as the loop below
+			long steps = 0;
+			for (; t < 0.; t += dt)
+				steps++;
+
+			Parareal pr(grn, steps, dt);
+			pr.threads = parareal;
+			pr.slices = parareal;
+			grn.setState(pr.run());
+			cerr << "parareal: " << pr.iterations() << " iterations on "
+				 << pr.slices << " slices\n";
+		}
+		// set second variable to 'true' to print the trajectory to stdout
+		run(0., false);
+		STATS_STOP(STATS_PREPATTERN);
+
+
+		//
+		// SIMULATION WITH PREDOMINANTLY ACTIVATING INPUT
+		//
+
+		gliVec <<	1.,		// GliA
+					0.;		// GliR
+		grn.setEffector(gliVec);
+		t = 0.;
+		ck.phase = 1;
+	}
 
-		// evolve by a step dt (Euler integration)
-		// set second variable to 'true' to add noise
-		grn.evolve(dt, noise);
+	STATS_START(STATS_PATTERN);
+	run(100., true);
+	STATS_STOP(STATS_PATTERN);
 
-		// uncomment below to print trajectory to stdout
-		cout << t << "\t" << grn << "\n";
-	}
+	STATS_START(STATS_OUTPUT);
 	cout.flush();
+	STATS_STOP(STATS_OUTPUT);
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONI");
 
 	return 0;
 
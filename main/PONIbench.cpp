@@ -0,0 +1,466 @@
+/******************************************************************************
+ *
+ *	PONIbench
+ *
+ *	Micro- and macro-benchmarks of the PONI engine and of the random number
+ *	generators.
+ *
+ *	Usage:	./PONIbench [-o output file] [-c reference file] [-t tolerance]
+ *
+ *	Prints a table to stdout and writes one JSON record per benchmark to the
+ *	output file (default "bench.json"). With -c, each result is compared to
+ *	the record with the same name in a previous output file, and the program
+ *	exits with an error if any benchmark is slower by more than the tolerance
+ *	(relative, default .15).
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <unordered_map>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/networks.h"
+#include "grn/netgrn.h"
+#include "grn/batch.h"
+#include "grn/lattice.h"
+#include "grn/hybrid.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+struct result {
+	string name;
+	int threads;
+	double nsPerStep;
+	double stepsPerSecCore;
+};
+
+vector<result> results;
+
+volatile double sink;		// keeps results of the benchmarks alive
+
+
+//
+//	time 'body' (which performs 'steps' steps per call) for at least 'minTime'
+//	seconds, and return the time per step in nanoseconds
+//
+double timeit (function<void()> body, double steps, double minTime = .3)
+{
+	typedef chrono::steady_clock clock;
+	long calls = 0;
+	double elapsed = 0.;
+	auto t0 = clock::now();
+	do {
+		body();
+		calls++;
+		elapsed = chrono::duration<double>(clock::now() - t0).count();
+	} while (elapsed < minTime);
+	return 1.e9 * elapsed / (calls * steps);
+}
+
+
+void record (string name, double ns, int threads = 1)
+{
+	result r = {name, threads, ns, 1.e9/ns/threads};
+	results.push_back(r);
+	cout << left << setw(36) << name << right << setw(4) << threads
+		 << setw(14) << fixed << setprecision(2) << ns << " ns/step"
+		 << setw(16) << scientific << setprecision(3) << r.stepsPerSecCore
+		 << " steps/s/core\n";
+}
+
+
+//
+//	PONI with the initial conditions and parameters of the drivers
+//
+PONI startPONI ()
+{
+	PONI grn;
+	grn.setParameters("Omega", 500.);
+	grn.setState(.95, .005, .005, .95);
+	grn.setEffector(0., 1.);
+	return grn;
+}
+
+
+PONI_h_t gliGradient(const double x)
+{
+	PONI_h_t gli;
+	double aux = exp(- x/0.15);
+	gli <<	aux, 1.- aux;
+	return gli;
+}
+
+
+//
+//	same as PONIpattern (deterministic), cells distributed over threads
+//
+void pattern (int nthreads, int ncells, double T)
+{
+	const double dt = .01;
+	const double dx = 1./ncells;
+
+	PONI start = startPONI();
+	for (double t = -1000.; t < 0.; t += dt)
+		start.evolve(dt, false);
+
+	// each thread writes its sum once, and sink is set after the join (a
+	// sink written by all the threads would be a data race, and hold the
+	// value of the last writer instead of the sum)
+	vector<double> sums(nthreads, 0.);
+	vector<thread> pool;
+	for (int n = 0; n < nthreads; n++)
+		pool.push_back(thread([=, &sums]() {
+			double acc = 0.;
+			for (int i = n; i < ncells; i += nthreads)
+			{
+				PONI grn = start;
+				grn.setEffector(gliGradient(i*dx));
+				for (double t = 0.; t < T; t += dt)
+					grn.evolve(dt, false);
+				acc += grn.getState()(2);
+			}
+			sums[n] = acc;
+		}));
+	for (auto& th : pool)
+		th.join();
+
+	double acc = 0.;
+	for (double v : sums)
+		acc += v;
+	sink = acc;
+}
+
+
+void writeResults (const char* filename)
+{
+	ofstream os(filename);
+	os << setprecision(6);
+	for (const auto& r : results)
+		os << "{\"name\": \"" << r.name << "\", \"threads\": " << r.threads
+		   << ", \"ns_per_step\": " << r.nsPerStep
+		   << ", \"steps_per_s_per_core\": " << r.stepsPerSecCore << "}\n";
+	os.close();
+}
+
+
+//
+//	compare with a previous output file, return the number of regressions
+//
+int compareResults (const char* filename, double tol)
+{
+	ifstream is(filename);
+	if (!is)
+	{
+		cout << "error: PONIbench: cannot open \"" << filename << "\"\n";
+		exit(EXIT_FAILURE);
+	}
+
+	unordered_map<string,double> ref;
+	string line;
+	while (getline(is, line))
+	{
+		size_t a = line.find("\"name\": \"");
+		size_t b = line.find("\"threads\": ");
+		size_t c = line.find("\"ns_per_step\": ");
+		if (a == string::npos || b == string::npos || c == string::npos)
+			continue;
+		a += 9;
+		string key = line.substr(a, line.find('"', a) - a) + "@"
+				   + to_string(atoi(line.c_str() + b + 11));
+		ref[key] = atof(line.c_str() + c + 15);
+	}
+
+	int nreg = 0;
+	cout << "\ncomparison with \"" << filename << "\"\n";
+	for (const auto& r : results)
+	{
+		auto it = ref.find(r.name + "@" + to_string(r.threads));
+		if (it == ref.end())
+			continue;
+		double ratio = r.nsPerStep / it->second;
+		bool slow = (ratio > 1. + tol);
+		nreg += slow;
+		cout << left << setw(36) << r.name << right << setw(4) << r.threads
+			 << setw(10) << fixed << setprecision(3) << ratio
+			 << (slow ? "   REGRESSION" : "") << "\n";
+	}
+	return nreg;
+}
+
+
+int main (int argc, char *argv[])
+{
+	const char* outfile = "bench.json";
+	const char* reffile = NULL;
+	double tol = .15;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-o") && i+1 < argc)
+			outfile = argv[++i];
+		else if (!strcmp(argv[i], "-c") && i+1 < argc)
+			reffile = argv[++i];
+		else if (!strcmp(argv[i], "-t") && i+1 < argc)
+			tol = atof(argv[++i]);
+		else
+		{
+			cout << "usage: " << argv[0]
+				 << " [-o output file] [-c reference file] [-t tolerance]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	const double dt = .01;
+	const int nrep = 10000;
+	const int hw = max(1u, thread::hardware_concurrency());
+
+	rlxd_init(1, 1);
+	rlxs_init(0, 1);
+
+
+	//
+	//	MICRO-BENCHMARKS
+	//
+
+	cout << "# micro-benchmarks\n";
+
+	{
+		PONI grn = startPONI();
+		record("PONI::setProdR", timeit([&]() {
+			double acc = 0.;
+			for (int i = 0; i < nrep; i++)
+				acc += grn.getProdR()(1);
+			sink = acc;
+		}, nrep));
+
+		record("PONI::evolve (deterministic)", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				grn.evolve(dt, false);
+		}, nrep));
+
+		grn = startPONI();
+		record("PONI::evolve (stochastic)", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				grn.evolve(dt, true);
+		}, nrep));
+
+		grn = startPONI();
+		record("PONI::integrate (deterministic)", timeit([&]() {
+			grn.integrate(nrep, dt, false);
+		}, nrep));
+
+		grn = startPONI();
+		record("PONI::integrate (stochastic)", timeit([&]() {
+			grn.integrate(nrep, dt, true);
+		}, nrep));
+
+		PONIhybrid hy(startPONI());
+		record("PONIhybrid::evolve", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				hy.evolve(dt);
+		}, nrep));
+	}
+
+	{
+		// per step of each cell
+		const int nc = 1024, nb = 100;
+		PONIbatch batch(startPONI(), nc);
+		record("PONIbatch::evolve (deterministic)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				batch.evolve(dt, false);
+			sink = batch.state()[0];
+		}, nb*nc));
+
+		batch = PONIbatch(startPONI(), nc);
+		record("PONIbatch::evolve (stochastic)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				batch.evolve(dt, true);
+			sink = batch.state()[0];
+		}, nb*nc));
+
+		batch = PONIbatch(startPONI(), nc);
+		batch.drawParameters("K_Pol_Oli", BATCH_LOGNORMAL, .2);
+		batch.drawParameters("alpha_Nkx", BATCH_LOGNORMAL, .2);
+		record("PONIbatch::evolve (per-cell pars)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				batch.evolve(dt, false);
+			sink = batch.state()[0];
+		}, nb*nc));
+
+		PONIlattice lattice(startPONI(), nc);
+		lattice.addCoupling("Oli", "Nkx", 20., .1);
+		record("PONIlattice::advance (coupled)", timeit([&]() {
+			lattice.advance(nb*dt, dt, false);
+			sink = lattice.state()[0];
+		}, nb*nc));
+	}
+
+	{
+		ThermoPONI grn;
+		grn.setParameters("Omega", 500.);
+		ThermoPONI::x_t x0;
+		x0 << .95, .005, .005, .95;
+		grn.setState(x0);
+		record("ThermoPONI::evolve (deterministic)", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				grn.evolve(dt, false);
+		}, nrep));
+
+		ThermoPONIf grnf;
+		grnf.setParameters("Omega", 500.);
+		grnf.setState(x0.cast<float>());
+		record("ThermoPONIf::evolve (stochastic)", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				grnf.evolve(dt, true);
+		}, nrep));
+
+		// ensembles, per step of each cell
+		const int nc = 1024, nb = 100;
+		ThermoPONIbatch ens(grn, nc);
+		record("ThermoPONIbatch::evolve (stochastic)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				ens.evolve(dt, true);
+			sink = ens.state()[0];
+		}, nb*nc));
+
+		ThermoPONIbatchf ensf(grnf, nc);
+		record("ThermoPONIbatchf::evolve (deterministic)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				ensf.evolve(dt, false);
+			sink = ensf.state()[0];
+		}, nb*nc));
+
+		ensf = ThermoPONIbatchf(grnf, nc);
+		record("ThermoPONIbatchf::evolve (stochastic)", timeit([&]() {
+			for (int i = 0; i < nb; i++)
+				ensf.evolve(dt, true);
+			sink = ensf.state()[0];
+		}, nb*nc));
+	}
+
+	{
+		ifstream netf("network_PONI.dat");
+		if (netf)
+		{
+			netf.close();
+			NetGRN grn("network_PONI.dat");
+			record("NetGRN::evolve (deterministic)", timeit([&]() {
+				for (int i = 0; i < nrep; i++)
+					grn.evolve(dt, false);
+			}, nrep));
+		}
+	}
+
+	{
+		const int n = 4;
+		double r[n];
+		record("gauss_dble", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				gauss_dble(r, n);
+			sink = r[0];
+		}, nrep*n));
+
+		for (int level = 1; level <= 2; level++)
+		{
+			rlxd_init(level, 1);
+			record("ranlxd (level " + to_string(level) + ")", timeit([&]() {
+				for (int i = 0; i < nrep; i++)
+					ranlxd(r, n);
+				sink = r[0];
+			}, nrep*n));
+		}
+		rlxd_init(1, 1);
+
+		// independent streams updated together (per number of each stream)
+		const int ns = 16;
+		double rv[ns*n];
+		for (int level = 1; level <= 2; level++)
+		{
+			rlxdv_init(ns, level, 1);
+			record("ranlxdv (level " + to_string(level) + ", " + rlxdv_isa() + ")",
+				timeit([&]() {
+					for (int i = 0; i < nrep; i++)
+						ranlxdv(rv, n);
+					sink = rv[0];
+				}, nrep*n*ns));
+		}
+		rlxdv_init(ns, 1, 1);
+		record("gauss_dblev", timeit([&]() {
+			for (int i = 0; i < nrep; i++)
+				gauss_dblev(rv, n);
+			sink = rv[0];
+		}, nrep*n*ns));
+	}
+
+
+	//
+	//	MACRO-BENCHMARKS
+	//
+
+	cout << "\n# macro-benchmarks\n";
+
+	// PONI.cpp: 1000 + 100 time units of a single trajectory
+	record("PONI run", timeit([&]() {
+		PONI grn = startPONI();
+		for (double t = -1000.; t < 0.; t += dt)
+			grn.evolve(dt, false);
+		grn.setEffector(1., 0.);
+		for (double t = 0.; t < 100.; t += dt)
+			grn.evolve(dt, false);
+		sink = grn.getState()(0);
+	}, 110000., 0.));
+
+	// same, with PONI::integrate
+	record("PONI run (integrate)", timeit([&]() {
+		PONI grn = startPONI();
+		grn.integrate(100000, dt, false);
+		grn.setEffector(1., 0.);
+		grn.integrate(10000, dt, false);
+		sink = grn.getState()(0);
+	}, 110000., 0.));
+
+	// PONIpattern.cpp: prepattern + 500 cells for 300 time units
+	record("PONIpattern run", timeit([&]() {
+		pattern(1, 500, 300.);
+	}, 100000. + 500*30000., 0.));
+
+	// strong scaling of the pattern over threads (shorter runs)
+	for (int n = 1; n <= hw; n *= 2)
+		record("PONIpattern scaling", timeit([&]() {
+			pattern(n, 512, 50.);
+		}, 100000. + 512*5000., 0.), n);
+
+	// compare before writing, the reference may be the output file
+	int nreg = 0;
+	if (reffile != NULL)
+		nreg = compareResults(reffile, tol);
+
+	writeResults(outfile);
+	cout << "\nresults written to \"" << outfile << "\"\n";
+
+	if (nreg > 0)
+	{
+		cout << nreg << " regression(s) above tolerance " << tol << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return 0;
+
+}
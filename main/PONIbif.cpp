@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ *	PONIbif
+ *
+ *	Branches of fixed points of the PONI network (Cohen et al. '14) as a
+ *	function of the level of Gli, by pseudo-arclength continuation.
+ *
+ *	Gli moves from the repressive (GliA = 0, GliR = 1) to the activating
+ *	input (GliA = 1, GliR = 0): g = GliA = 1 - GliR. Two branches are traced:
+ *	the one of the prepattern state from g = 0, and the one of the state
+ *	reached from the prepattern at g = 1. Folds delimit the ranges of
+ *	bistability, and thus the positions of the domain boundaries.
+ *
+ *	Gives as output, for each point of the branches:
+ *	g, position in the gradient of PONIpattern, Pax, Olig, Nkx, Irx,
+ *	largest real part of the eigenvalues of the Jacobian, stability (1/0).
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/continuation.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+//
+//	position along the gradient of PONIpattern, GliA = exp(- x/0.15)
+//
+double gliPosition(const double g)
+{
+	return (g > 0.) ? - 0.15 * log(g) : INFINITY;
+}
+
+
+void printBranch(const vector<BifPoint>& br, int k)
+{
+	cout << "# branch " << k << "\n";
+	for (const auto& p : br)
+	{
+		if (p.fold)
+			continue;
+		cout << p.g << "\t" << gliPosition(p.g) << "\t"
+			 << p.x.transpose() << "\t" << p.lambda << "\t" << p.stable << "\n";
+	}
+	cout << "\n\n";
+}
+
+
+int main (int argc, char *argv[])
+{
+
+	cout << fixed;
+	cout << setprecision(6);
+
+	PONI grn;
+
+	// use first command line argument as filename with parameters
+	if (argc == 2) grn.setParameters(argv[1]);
+
+	Continuation cont(grn);
+
+
+	//
+	// PREPATTERN STATE (g = 0)
+	//
+
+	PONI_x_t x0;
+	x0 << .95, .005, .005, .95;
+	STATS_START(STATS_PATTERN);
+	if (!cont.steadyState(0., x0))
+		cerr << "warning: PONIbif: prepattern state not converged\n";
+
+	// state reached from the prepattern at the ventral end (g = 1)
+	PONI_x_t x1 = x0;
+	if (!cont.steadyState(1., x1))
+		cerr << "warning: PONIbif: ventral state not converged\n";
+
+
+	//
+	// CONTINUATION
+	//
+
+	vector<vector<BifPoint>> branches;
+	branches.push_back(cont.branch(0., x0, +1));
+
+	// the ventral state is on a separate branch unless the first one
+	// already got to it
+	if ((branches[0].back().x - x1).norm() > 1.e-2)
+		branches.push_back(cont.branch(1., x1, -1));
+	STATS_STOP(STATS_PATTERN);
+
+	for (unsigned k = 0; k < branches.size(); k++)
+		printBranch(branches[k], k);
+
+	// folds
+	cout << "# folds: g, position, Pax, Olig, Nkx, Irx\n";
+	for (const auto& br : branches)
+		for (const auto& p : br)
+			if (p.fold)
+				cout << "# " << p.g << "\t" << gliPosition(p.g) << "\t"
+					 << p.x.transpose() << "\n";
+
+	cout.flush();
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIbif");
+
+	return 0;
+
+}
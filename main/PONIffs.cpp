@@ -0,0 +1,176 @@
+/******************************************************************************
+ *
+ *	PONIffs
+ *
+ *	Rate of the noise-driven switch of a PONI cell (Cohen et al. '14) from
+ *	the Pax state to the Olig state, at a constant level of Gli where both
+ *	are stable, by forward flux sampling (see ../include/grn/ffs.h).
+ *
+ *	Usage:	./PONIffs [parameter file] [--g GliA] [--omega Omega]
+ *						[--interfaces n] [--points n] [--trials n]
+ *						[--threads n] [--seed n] [--paths file]
+ *
+ *	The order parameter is Olig - Pax. State A is the Pax state reached from
+ *	the prepattern, state B the Olig state; the n interfaces are equally
+ *	spaced between them (at .1 from both). A trial fails when it goes back
+ *	below the order parameter of the deterministic Pax state.
+ *
+ *	Gives as output the flux out of A, the probabilities of reaching each
+ *	interface from the previous one, and the switching rate. With --paths
+ *	the transition paths are written to file (time, Pax, Olig, Nkx, Irx;
+ *	paths separated by blank lines).
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/ffs.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization
+
+	const char* parfile = NULL;		// file with parameters
+	const char* pathfile = NULL;	// file for the transition paths
+	double g = .03;					// level of GliA (GliR = 1 - GliA)
+	double Omega = 500.;
+	int nif = 8, points = 1000, trials = 1000, seed = 1;
+	int threads = thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--g") && i+1 < argc)
+			g = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--omega") && i+1 < argc)
+			Omega = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--interfaces") && i+1 < argc)
+			nif = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--points") && i+1 < argc)
+			points = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--trials") && i+1 < argc)
+			trials = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--threads") && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i+1 < argc)
+			seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--paths") && i+1 < argc)
+			pathfile = argv[++i];
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] [--g GliA] "
+				 << "[--omega Omega] [--interfaces n] [--points n] [--trials n] "
+				 << "[--threads n] [--seed n] [--paths file]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (nif < 2 || threads < 1)
+	{
+		cout << "error: PONIffs: at least two interfaces and one thread are needed\n";
+		return EXIT_FAILURE;
+	}
+
+
+	//
+	// STATES A (PAX, FROM THE PREPATTERN) AND B (OLIG)
+	//
+
+	PONI A, B;
+	if (parfile != NULL) A.setParameters(parfile);
+	A.setParameters("Omega", Omega);
+	A.setState(.95, .005, .005, .95);
+	A.setEffector(0., 1.);
+	for (double t = -1000.; t < 0.; t += dt)
+		A.evolve(dt, false);
+
+	A.setEffector(g, 1. - g);
+	B = A;
+	B.setState(.005, .95, .005, .005);
+	STATS_START(STATS_PREPATTERN);
+	for (double t = 0.; t < 1000.; t += dt)
+	{
+		A.evolve(dt, false);
+		B.evolve(dt, false);
+	}
+	STATS_STOP(STATS_PREPATTERN);
+
+	auto order = [](const PONI_x_t& x) { return x(1) - x(0); };
+	double lA = order(A.getState()), lB = order(B.getState());
+	if (lB - lA < .3)
+	{
+		cout << "error: PONIffs: no distinct Pax and Olig states at GliA = " << g << "\n";
+		return EXIT_FAILURE;
+	}
+
+	vector<double> iface(nif);
+	for (int i = 0; i < nif; i++)
+		iface[i] = (lA + .1) + i*((lB - .1) - (lA + .1))/(nif - 1);
+
+
+	//
+	// FORWARD FLUX SAMPLING
+	//
+
+	FFS ffs(A, order, iface);
+	ffs.lambdaA = lA;		// A: back to the deterministic Pax state
+	ffs.dt = dt;
+	ffs.points = points;
+	ffs.trials = trials;
+	ffs.threads = threads;
+	ffs.seed = seed;
+	STATS_START(STATS_PATTERN);
+	ffs.run();
+	STATS_STOP(STATS_PATTERN);
+
+	cout << scientific << setprecision(6);
+	cout << "# GliA = " << g << ", Omega = " << Omega << "\n";
+	cout << "# flux through lambda_0 = " << iface[0] << ":\t" << ffs.flux() << "\n";
+	cout << "# interface\tlambda\tP(reach | previous)\ttimeouts\n";
+	for (int i = 1; i < nif; i++)
+		cout << i << "\t" << iface[i] << "\t" << ffs.probabilities()[i-1]
+			 << "\t" << ((i-1 < (int) ffs.timeouts().size()) ? ffs.timeouts()[i-1] : 0) << "\n";
+	cout << "# rate A -> B:\t" << ffs.rate() << "\n";
+	cout << "# mean time:\t" << 1./ffs.rate() << "\n";
+
+	if (pathfile != NULL)
+	{
+		vector<vector<double>> times;
+		vector<FFS_path_t> paths = ffs.paths(&times);
+		ofstream os(pathfile);
+		os << fixed << setprecision(6);
+		for (unsigned p = 0; p < paths.size(); p++)
+		{
+			for (unsigned s = 0; s < paths[p].size(); s++)
+				os << times[p][s] << "\t" << paths[p][s].transpose() << "\n";
+			os << "\n\n";
+		}
+		os.close();
+		cout << "# " << paths.size() << " transition paths written to \""
+			 << pathfile << "\"\n";
+	}
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIffs");
+
+	return 0;
+
+}
@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ *	PONIfit
+ *
+ *	Fitting the parameters of the PONI network (Cohen et al. '14) to the
+ *	positions of the domain boundaries (or to the widths of the domains) in
+ *	the gradient of PONIpattern, by ABC-SMC (see ../include/grn/abc.h).
+ *
+ *	Usage:	./PONIfit fit file [--threads n] [--output prefix] [--resume file]
+ *
+ *	The fit file contains lines "keyword values":
+ *
+ *		fit			name lo hi [log]	parameter to fit, with uniform prior in
+ *										[lo,hi] (of the logarithm with 'log')
+ *		summary		boundaries|widths
+ *		target		values of the summary statistic
+ *		particles	size of the population
+ *		generations	number of generations
+ *		alpha		quantile of the distances giving the next tolerance
+ *		seed		seed of ranlxd
+ *
+ *	any other line sets the value of a (fixed) parameter of the network.
+ *	Lines starting with '#' are comments.
+ *
+ *	Gives as output a line per generation: generation, tolerance, number of
+ *	simulations so far, weighted mean of the parameters. Each population is
+ *	written to "prefix_gen<generation>.dat", and --resume continues from it.
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include "random.h"
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/abc.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+int main (int argc, char *argv[])
+{
+
+	cout << setprecision(6);
+
+	const char* fitfile = NULL;		// fit settings
+	const char* resume = NULL;		// population to resume from
+	string prefix = "PONIfit";		// prefix of the population files
+	int threads = thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+
+	auto usage = [&]() {
+		cout << "usage: " << argv[0] << " fit file [--threads n] "
+			 << "[--output prefix] [--resume file]\n";
+		return EXIT_FAILURE;
+	};
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--threads") && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--output") && i+1 < argc)
+			prefix = argv[++i];
+		else if (!strcmp(argv[i], "--resume") && i+1 < argc)
+			resume = argv[++i];
+		else if (fitfile == NULL && argv[i][0] != '-')
+			fitfile = argv[i];
+		else
+			return usage();
+	}
+	if (fitfile == NULL || threads < 1)
+		return usage();
+
+
+	//
+	//	READ FIT FILE
+	//
+
+	PONI cell;
+	vector<ABCParameter> fit;
+	vector<double> target;
+	string summary = "boundaries";
+	int particles = 100, generations = 5, seed = 1;
+	double alpha = .5;
+
+	ifstream in(fitfile);
+	if (!in)
+	{
+		cout << "error: PONIfit: cannot read \"" << fitfile << "\"\n";
+		return EXIT_FAILURE;
+	}
+	string line, key;
+	while (getline(in, line))
+	{
+		istringstream ls(line);
+		if (!(ls >> key) || key[0] == '#')
+			continue;
+
+		if (key == "fit")
+		{
+			ABCParameter p;
+			string lg;
+			if (!(ls >> p.name >> p.lo >> p.hi))
+			{
+				cout << "error: PONIfit: invalid line \"" << line << "\"\n";
+				return EXIT_FAILURE;
+			}
+			p.log = (ls >> lg && lg == "log");
+			fit.push_back(p);
+		}
+		else if (key == "summary")
+			ls >> summary;
+		else if (key == "target")
+		{
+			double v;
+			while (ls >> v)
+				target.push_back(v);
+		}
+		else if (key == "particles")
+			ls >> particles;
+		else if (key == "generations")
+			ls >> generations;
+		else if (key == "alpha")
+			ls >> alpha;
+		else if (key == "seed")
+			ls >> seed;
+		else
+		{
+			double v;
+			if (!(ls >> v))
+			{
+				cout << "error: PONIfit: invalid line \"" << line << "\"\n";
+				return EXIT_FAILURE;
+			}
+			cell.setParameters(key, v);
+		}
+	}
+	in.close();
+
+	ABC_summary_t stat;
+	if (summary == "boundaries")
+		stat = patternBoundaries;
+	else if (summary == "widths")
+		stat = domainWidths;
+	else
+	{
+		cout << "error: PONIfit: unknown summary \"" << summary << "\"\n";
+		return EXIT_FAILURE;
+	}
+
+
+	//
+	//	ABC-SMC
+	//
+
+	ABCSMC abc(cell, stat, target);
+	for (const auto& p : fit)
+		abc.addParameter(p.name, p.lo, p.hi, p.log);
+	abc.particles = particles;
+	abc.alpha = alpha;
+	abc.threads = threads;
+
+	rlxd_init(1, seed);
+	if (resume != NULL)
+		abc.read(resume);
+
+	cout << "# generation\tepsilon\tsimulations";
+	for (const auto& p : fit)
+		cout << "\t" << p.name;
+	cout << "\n";
+
+	while (abc.generation() + 1 < generations)
+	{
+		STATS_START(STATS_PATTERN);
+		abc.step();
+		STATS_STOP(STATS_PATTERN);
+
+		ostringstream name;
+		name << prefix << "_gen" << abc.generation() << ".dat";
+		abc.write(name.str().c_str());
+
+		cout << abc.generation() << "\t" << abc.epsilon() << "\t" << abc.simulations();
+		for (double m : abc.mean())
+			cout << "\t" << m;
+		cout << endl;
+	}
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIfit");
+
+	return 0;
+
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+ *
+ *	PONIgmam
+ *
+ *	Minimum action paths of a PONI cell (Cohen et al. '14) between the Pax
+ *	and the Olig states, at a constant level of Gli where both are stable,
+ *	by the geometric minimum action method (see ../include/grn/gmam.h).
+ *
+ *	Usage:	./PONIgmam [parameter file] [--g GliA] [--nodes n] [--tau step]
+ *						[--paths file]
+ *
+ *	The paths Pax -> Olig and Olig -> Pax are relaxed on two threads.
+ *
+ *	Gives as output the two states, the saddle between them and the action
+ *	barriers in both directions: for large Omega the switching rates are
+ *	~ exp(-Omega*S). With --paths the two paths are written to file (action
+ *	accumulated along the path, Pax, Olig, Nkx, Irx; paths separated by
+ *	blank lines).
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/gmam.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization
+
+	const char* parfile = NULL;		// file with parameters
+	const char* pathfile = NULL;	// file for the paths
+	double g = .03;					// level of GliA (GliR = 1 - GliA)
+	double tau = .01;
+	int nodes = 100;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--g") && i+1 < argc)
+			g = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--nodes") && i+1 < argc)
+			nodes = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--tau") && i+1 < argc)
+			tau = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--paths") && i+1 < argc)
+			pathfile = argv[++i];
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] [--g GliA] "
+				 << "[--nodes n] [--tau step] [--paths file]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+
+	//
+	// STATES A (PAX, FROM THE PREPATTERN) AND B (OLIG)
+	//
+
+	PONI A, B;
+	if (parfile != NULL) A.setParameters(parfile);
+	A.setState(.95, .005, .005, .95);
+	A.setEffector(0., 1.);
+	STATS_START(STATS_PREPATTERN);
+	for (double t = -1000.; t < 0.; t += dt)
+		A.evolve(dt, false);
+
+	A.setEffector(g, 1. - g);
+	B = A;
+	B.setState(.005, .95, .005, .005);
+	for (double t = 0.; t < 1000.; t += dt)
+	{
+		A.evolve(dt, false);
+		B.evolve(dt, false);
+	}
+	STATS_STOP(STATS_PREPATTERN);
+
+	PONI_x_t xA = A.getState(), xB = B.getState();
+	if ((xA - xB).norm() < .1)
+	{
+		cout << "error: PONIgmam: no distinct Pax and Olig states at GliA = " << g << "\n";
+		return EXIT_FAILURE;
+	}
+
+
+	//
+	// MINIMUM ACTION PATHS
+	//
+
+	GMAM AB(A, xA, xB, nodes), BA(A, xB, xA, nodes);
+	AB.tau = BA.tau = tau;
+
+	int itAB, itBA;
+	STATS_START(STATS_PATTERN);
+	thread worker([&]() { itBA = BA.relax(); });
+	itAB = AB.relax();
+	worker.join();
+	STATS_STOP(STATS_PATTERN);
+
+	cout << scientific << setprecision(6);
+	cout << "# GliA = " << g << "\n";
+	cout << "# Pax state:\t" << xA.transpose() << "\n";
+	cout << "# Olig state:\t" << xB.transpose() << "\n";
+	cout << "# saddle:\t" << AB.saddle().transpose() << "\n";
+	cout << "# action Pax -> Olig:\t" << AB.action()
+		 << "\t(" << itAB << " iterations, residual " << AB.residual() << ")\n";
+	cout << "# action Olig -> Pax:\t" << BA.action()
+		 << "\t(" << itBA << " iterations, residual " << BA.residual() << ")\n";
+
+	if (pathfile != NULL)
+	{
+		ofstream os(pathfile);
+		os << fixed << setprecision(8);
+		for (GMAM* p : {&AB, &BA})
+		{
+			for (unsigned i = 0; i < p->path().size(); i++)
+				os << p->quasiPotential()[i] << "\t" << p->path()[i].transpose() << "\n";
+			os << "\n\n";
+		}
+		os.close();
+	}
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIgmam");
+
+	return 0;
+
+}
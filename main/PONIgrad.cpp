@@ -0,0 +1,117 @@
+/******************************************************************************
+ *
+ *	PONIgrad
+ *
+ *	Derivatives of the final state of a cell of PONIpattern (prepattern,
+ *	then constant Gli at position x in the gradient) with respect to the
+ *	parameters of the PONI network (Cohen et al. '14).
+ *
+ *	Usage:	./PONIgrad [parameter file] [--x position]
+ *
+ *	Gives as output, for each parameter: name, derivatives of Pax, Olig, Nkx,
+ *	Irx from the forward sensitivities, derivative of Olig from the discrete
+ *	adjoint (the same as the second column, at the cost of one backward
+ *	solve for all the parameters).
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/sensitivity.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+//
+//	exponential gradient of effector (Gli), as in PONIpattern
+//
+PONI_h_t gliGradient(const double x)
+{
+	PONI_h_t gli;
+	double aux = exp(- x/0.15);
+	gli <<	aux, 1.- aux;
+	return gli;
+}
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization
+	double x = .3;			// position of the cell
+
+	cout << scientific;
+	cout << setprecision(6);
+
+	const char* parfile = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--x") && i+1 < argc)
+			x = atof(argv[++i]);
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] [--x position]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	PONI start, grn;
+	if (parfile != NULL) start.setParameters(parfile);
+	start.setState(.95, .005, .005, .95);
+	start.setEffector(0., 1.);
+
+
+	//
+	// FORWARD SENSITIVITIES (PREPATTERN, THEN PATTERN)
+	//
+
+	PONI_P_t S = PONI_P_t::Zero();
+	grn = start;
+	STATS_START(STATS_PATTERN);
+	forwardSensitivity(grn, 1000., dt, S);
+	PONI pre = grn;		// prepattern state, initial condition of the cell
+	grn.setEffector(gliGradient(x));
+	forwardSensitivity(grn, 300., dt, S);
+
+
+	//
+	// ADJOINT OF THE OLIG LEVEL
+	//
+
+	PONI_x_t e1, lambda;
+	e1 << 0., 1., 0., 0.;
+	pre.setEffector(gliGradient(x));
+	PONI_g_t grad = adjointGradient(pre, 300., dt, e1, &lambda);
+	grad += adjointGradient(start, 1000., dt, lambda);
+	STATS_STOP(STATS_PATTERN);
+
+
+	cout << "# x = " << x << ", final state: " << grn.getState().transpose() << "\n";
+	cout << "# parameter\tdPax\tdOlig\tdNkx\tdIrx\tdOlig (adjoint)\n";
+	const vector<string>& names = PONI::parameterNames();
+	for (int k = 0; k < PONI_NPAR; k++)
+	{
+		cout << names[k];
+		for (int i = 0; i < 4; i++)
+			cout << "\t" << S(i,k);
+		cout << "\t" << grad(k) << "\n";
+	}
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIgrad");
+
+	return 0;
+
+}
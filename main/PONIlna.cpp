@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *	PONIlna
+ *
+ *	Mean and fluctuations of the protein levels of a PONI network (Cohen et
+ *	al. '14) with low copy-number noise, from the linear noise approximation
+ *	(or the Gaussian moment closure), in the same protocol as PONI.cpp.
+ *
+ *	Usage:	./PONIlna [parameter file] [--closure linear|gaussian]
+ *
+ *	Gives as output the time evolution of the mean protein levels and of
+ *	their standard deviations.
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/lna.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization
+
+	const char* parfile = NULL;		// file with parameters
+	int closure = LNA_LINEAR;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--closure") && i+1 < argc && !strcmp(argv[i+1], "linear"))
+			closure = LNA_LINEAR, i++;
+		else if (!strcmp(argv[i], "--closure") && i+1 < argc && !strcmp(argv[i+1], "gaussian"))
+			closure = LNA_GAUSSIAN, i++;
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] "
+				 << "[--closure linear|gaussian]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	PONI grn;
+	PONI_h_t gliVec;	// vector containing GliA and GliR
+
+	//
+	//	SET PARAMETERS AND INITIAL CONDITIONS (AS IN PONI.cpp)
+	//
+
+	if (parfile != NULL) grn.setParameters(parfile);
+	grn.setParameters("Omega", 500.);
+	grn.setState(.95, .005, .005, .95);
+
+	LNA lna(grn, closure);
+
+
+	//
+	// STEADY STATE FOR PREDOMINANTLY REPRESSIVE INPUT
+	//
+
+	gliVec <<	0.,		// GliA
+				1.;		// GliR
+	lna.setEffector(gliVec);
+
+	STATS_START(STATS_PREPATTERN);
+	for (double t = -1000.; t < 0.; t += dt)
+		lna.evolve(dt);
+	STATS_STOP(STATS_PREPATTERN);
+
+
+	//
+	// EVOLUTION WITH PREDOMINANTLY ACTIVATING INPUT
+	//
+
+	gliVec <<	1.,		// GliA
+				0.;		// GliR
+	lna.setEffector(gliVec);
+
+	STATS_START(STATS_PATTERN);
+	for (double t = 0.; t < 100.; t += dt) {
+
+		lna.evolve(dt);
+
+		// mean and standard deviations
+		STATS_STOP(STATS_PATTERN);
+		STATS_START(STATS_OUTPUT);
+		cout << t << "\t" << lna << "\n";
+		STATS_STOP(STATS_OUTPUT);
+		STATS_START(STATS_PATTERN);
+	}
+	STATS_STOP(STATS_PATTERN);
+
+	cout.flush();
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIlna");
+
+	return 0;
+
+}
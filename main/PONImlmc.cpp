@@ -0,0 +1,161 @@
+/******************************************************************************
+ *
+ *	PONImlmc
+ *
+ *	Mean position of the boundary between the Nkx (p3) and Olig (pMN)
+ *	domains of the pattern of PONIpattern with noise, by multilevel Monte
+ *	Carlo (see ../include/grn/mlmc.h).
+ *
+ *	Usage:	./PONImlmc [parameter file] [--eps tol] [--omega Omega]
+ *						 [--cells n] [--time T] [--dt0 dt] [--threads n]
+ *						 [--seed n]
+ *
+ *	The cells (n on [0,1), in the gradient of Gli of PONIpattern) start from
+ *	the deterministic prepattern and evolve with noise for a time T. The
+ *	boundary is the first position where Olig exceeds Nkx (interpolated
+ *	between the cells, 1 if there is none).
+ *
+ *	Gives as output, for each level, the samples, mean and variance of the
+ *	differences and the mean boundary of the fine paths, then the estimate
+ *	and the cost (in steps of a cell) compared with that of plain Monte
+ *	Carlo at the step of the finest level for the same tolerance.
+ *
+ *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MAIN_PROGRAM
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/mlmc.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+int main (int argc, char *argv[])
+{
+
+	const double dt = .01;	// time discretization of the prepattern
+
+	const char* parfile = NULL;		// file with parameters
+	double eps = .005;				// tolerance on the boundary
+	double Omega = 500.;
+	double T = 300.;				// time of the pattern
+	double dt0 = .1;				// step of level 0
+	int ncells = 100, seed = 1;
+	int threads = thread::hardware_concurrency();
+	if (threads < 1) threads = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--eps") && i+1 < argc)
+			eps = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--omega") && i+1 < argc)
+			Omega = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--cells") && i+1 < argc)
+			ncells = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--time") && i+1 < argc)
+			T = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--dt0") && i+1 < argc)
+			dt0 = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--threads") && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i+1 < argc)
+			seed = atoi(argv[++i]);
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] [--eps tol] "
+				 << "[--omega Omega] [--cells n] [--time T] [--dt0 dt] "
+				 << "[--threads n] [--seed n]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (!(eps > 0.) || ncells < 2 || threads < 1 || !(T > 0.) || !(dt0 > 0.))
+	{
+		cout << "error: PONImlmc: invalid tolerance, cells, threads, time or step\n";
+		return EXIT_FAILURE;
+	}
+
+
+	//
+	// PREPATTERN AND CELLS IN THE GRADIENT
+	//
+
+	PONI start;
+	if (parfile != NULL) start.setParameters(parfile);
+	start.setParameters("Omega", Omega);
+	start.setState(.95, .005, .005, .95);
+	start.setEffector(0., 1.);
+	for (double t = -1000.; t < 0.; t += dt)
+		start.evolve(dt, false);
+
+	PONIbatch cells(start, ncells);
+	vector<double> eff(2*ncells);
+	for (int i = 0; i < ncells; i++)
+	{
+		double aux = exp(- (double) i/ncells/0.15);
+		eff[i] = aux;
+		eff[ncells + i] = 1. - aux;
+	}
+	cells.setEffectors(eff.data());
+
+	// first crossing of Olig over Nkx
+	auto boundary = [](const PONIbatch& b) {
+		const int n = b.size();
+		const double* x = b.state();
+		for (int i = 1; i < n; i++)
+		{
+			double d0 = x[2*n + i-1] - x[n + i-1], d1 = x[2*n + i] - x[n + i];
+			if (d0 >= 0. && d1 < 0.)
+				return (i - 1 + d0/(d0 - d1))/n;
+		}
+		return 1.;
+	};
+
+
+	//
+	// MULTILEVEL MONTE CARLO
+	//
+
+	MLMC mlmc(cells, boundary);
+	mlmc.T = T;
+	mlmc.dt0 = dt0;
+	mlmc.threads = threads;
+	mlmc.seed = seed;
+	STATS_START(STATS_PATTERN);
+	double E = mlmc.estimate(eps);
+	STATS_STOP(STATS_PATTERN);
+
+	const int L = mlmc.levels() - 1;
+	cout << scientific << setprecision(6);
+	cout << "# Omega = " << Omega << ", " << ncells << " cells, T = " << T
+		 << ", eps = " << eps << "\n";
+	cout << "# level\tdt\tsamples\tmean(Y)\tvar(Y)\tmean(P)\n";
+	for (int l = 0; l <= L; l++)
+		cout << l << "\t" << dt0/pow(mlmc.M, l) << "\t" << mlmc.samples(l)
+			 << "\t" << mlmc.mean(l) << "\t" << mlmc.variance(l)
+			 << "\t" << mlmc.meanFine(l) << "\n";
+	cout << "# boundary:\t" << E << "\n";
+
+	double plain = 2.*mlmc.varianceFine(L)/(eps*eps) * T/(dt0/pow(mlmc.M, L));
+	cout << "# cost (steps of a cell):\t" << mlmc.cost()*ncells
+		 << "\t(plain Monte Carlo " << plain*ncells << ")\n";
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONImlmc");
+
+	return 0;
+
+}
@@ -7,6 +7,37 @@
  *
  *	Gives as output the final pattern (protein levels as function of space).
  *
+ *	Usage:	./PONIpattern [parameter file] [--checkpoint file [--interval steps]]
+ *						  [--resume file] [--table file] [--dx spacing]
+ *						  [--adaptive tol [--dxmin spacing]]
+ *						  [--couple target source K f ... [--threads n]]
+ *						  [--parareal threads]
+ *
+ *	Checkpoints work as in PONI.cpp: the simulation (prepattern, current cell,
+ *	position on the lattice and random number generator) is saved every
+ *	'interval' steps, and --resume continues exactly from there.
+ *
+ *	With --table the cells are not simulated one by one: their final states
+ *	are interpolated from a table of responses to Gli (grn/response.h), built
+ *	once and cached in 'file' (rebuilt if the parameters change). The table
+ *	does not depend on the gradient nor on the lattice spacing (--dx).
+ *
+ *	With --adaptive the lattice starts with spacing dx and the intervals
+ *	whose end cells differ by more than 'tol' (in any gene) are bisected,
+ *	down to 'dxmin'. Cells are printed in order of position, followed by the
+ *	positions of the domain boundaries (lines starting with '#').
+ *
+ *	With --couple (repeatable) the cells of the pattern evolve together on a
+ *	lattice (grn/lattice.h), and the production of the target gene of each
+ *	cell is regulated by the mean level of the source gene in the two
+ *	neighbouring cells, s, through the factor (1 + f K s)/(1 + K s). The
+ *	lattice is updated by 'n' threads; checkpoints save the whole lattice,
+ *	with its couplings and the generators of its tiles, so that they are
+ *	resumed without --couple.
+ *
+ *	With --parareal the (deterministic) prepattern is integrated in parallel
+ *	in time as in PONI.cpp.
+ *
  *	Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
  *
  *****************************************************************************/
@@ -17,8 +48,18 @@
 #include <cmath>
 #include <cstdlib>
 #include <iomanip>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
 #include "random.h"
+#include "stats.h"
 #include "grn/poni.h"
+#include "grn/checkpoint.h"
+#include "grn/response.h"
+#include "grn/lattice.h"
+#include "grn/parareal.h"
 
 using namespace Eigen;
 using namespace std;
@@ -40,13 +81,92 @@ int main (int argc, char *argv[])
 {
 
 	const double dt = .01;	// time discretization
-	const double dx = .002;	// lattice spacing
+	double dx = .002;		// lattice spacing
 
 	cout << fixed;
 	cout << setprecision(6);
 
 	bool noise = false;		// whether to include low copy-number noise
 
+	const char* parfile = NULL;		// file with parameters
+	const char* ckfile = NULL;		// file where checkpoints are written
+	const char* resume = NULL;		// checkpoint to resume from
+	const char* table = NULL;		// cache of the table of responses
+	double adaptive = 0.;			// tolerance of the adaptive lattice
+	double dxMin = 1.e-6;			// smallest spacing of the adaptive lattice
+	long interval = 1000000;		// steps between checkpoints
+	int threads = 1;				// threads of the coupled lattice
+	int parareal = 0;				// threads of the parallel prepattern
+
+	// couplings between neighbouring cells (target, source, K, f)
+	struct coupling { string target, source; double K, f; };
+	vector<coupling> couplings;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--checkpoint") && i+1 < argc)
+			ckfile = argv[++i];
+		else if (!strcmp(argv[i], "--interval") && i+1 < argc)
+			interval = atol(argv[++i]);
+		else if (!strcmp(argv[i], "--resume") && i+1 < argc)
+			resume = argv[++i];
+		else if (!strcmp(argv[i], "--table") && i+1 < argc)
+			table = argv[++i];
+		else if (!strcmp(argv[i], "--dx") && i+1 < argc)
+			dx = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--adaptive") && i+1 < argc)
+			adaptive = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--dxmin") && i+1 < argc)
+			dxMin = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--couple") && i+4 < argc)
+		{
+			couplings.push_back({argv[i+1], argv[i+2], atof(argv[i+3]), atof(argv[i+4])});
+			i += 4;
+		}
+		else if (!strcmp(argv[i], "--threads") && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--parareal") && i+1 < argc)
+			parareal = atoi(argv[++i]);
+		else if (parfile == NULL && argv[i][0] != '-')
+			parfile = argv[i];
+		else
+		{
+			cout << "usage: " << argv[0] << " [parameter file] "
+				 << "[--checkpoint file [--interval steps]] [--resume file] "
+				 << "[--table file] [--dx spacing] "
+				 << "[--adaptive tol [--dxmin spacing]] "
+				 << "[--couple target source K f ... [--threads n]] "
+				 << "[--parareal threads]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (interval < 1) interval = 1;
+	if (!(dx > 0.) || !(dxMin > 0.) || adaptive < 0.)
+	{
+		cout << "error: PONIpattern: the lattice spacing and the tolerance must be positive\n";
+		return EXIT_FAILURE;
+	}
+	if (adaptive > 0. && (table != NULL || ckfile != NULL || resume != NULL))
+	{
+		cout << "error: PONIpattern: --adaptive excludes --table and checkpoints\n";
+		return EXIT_FAILURE;
+	}
+	if (!couplings.empty() && (adaptive > 0. || table != NULL))
+	{
+		cout << "error: PONIpattern: --couple excludes --adaptive and --table\n";
+		return EXIT_FAILURE;
+	}
+	if (parareal != 0 && (parareal < 1 || noise || ckfile != NULL || resume != NULL))
+	{
+		cout << "error: PONIpattern: --parareal needs threads, no noise and no checkpoints\n";
+		return EXIT_FAILURE;
+	}
+	if (table != NULL && noise)
+	{
+		cout << "error: PONIpattern: the table of responses is deterministic\n";
+		return EXIT_FAILURE;
+	}
+
 	// initialize pseudo-random number generator
 	if (noise)
 	{
@@ -75,7 +195,7 @@ int main (int argc, char *argv[])
 	// use first command line argument as filename with parameters
 	// if none is passed, the default are used
 	// (the file may contain only a subset of the parameters, others are set to default)
-	if (argc == 2) start.setParameters(argv[1]);
+	if (parfile != NULL) start.setParameters(parfile);
 
 	// possible to set parameters individually by name
 	// e.g. parameter for strength of the noise (system size)
@@ -94,19 +214,292 @@ int main (int argc, char *argv[])
 	// start.setState(.95, .005, .005, .95);
 
 
+	//
+	// CHECKPOINTS
+	//
+	// phase 0: prepattern, phase 1: pattern (cell at position x, time t),
+	// phase 2: coupled cells (lattice at time t)
+
+	Checkpoint ck;
+	ck.rng = noise;
+	double t = -1000.;
+	double x = 0.;
+	bool inCell = false;	// resuming in the middle of a cell
+
+	if (resume != NULL)
+	{
+		ck.read(resume);
+		start = ck.cells[0];
+		grn = ck.cells[1];
+		t = ck.t;
+		x = ck.loop[0];
+		inCell = (ck.phase == 1);
+
+		// the lattice of a coupled run is in the checkpoint, with its couplings
+		if (ck.phase == 1 && !couplings.empty())
+		{
+			cout << "error: PONIpattern: \"" << resume << "\" is a checkpoint of "
+				 << "independent cells, it cannot be resumed with --couple\n";
+			return EXIT_FAILURE;
+		}
+		if (ck.phase == 2 && (table != NULL || ck.lattices.size() != 1))
+		{
+			cout << "error: PONIpattern: \"" << resume << "\" is a checkpoint of "
+				 << "coupled cells (with one lattice), it cannot be resumed with --table\n";
+			return EXIT_FAILURE;
+		}
+		cerr << "resuming from \"" << resume << "\" (phase " << ck.phase
+			 << ", x = " << x << ", t = " << t << "): keep the first "
+			 << ck.lines << " lines of the previous output\n";
+	}
+
+	// save the simulation, which continues at time t
+	auto checkpoint = [&]() {
+		ck.t = t;
+		ck.loop.assign(1, x);
+		ck.cells = {start, grn};
+		ck.write(ckfile);
+	};
+
+	// evolve 'cell' by steps dt while t < tend (Euler integration, with
+	// noise if 'noise' is true) in the fused kernel PONI::integrate: the
+	// observer advances t and stops the kernel when a checkpoint is due,
+	// which is written between the steps
+	auto run = [&](PONI& cell, double tend) {
+		long n = 0;
+		for (double s = t; s < tend; s += dt)
+			n++;
+
+		while (n > 0)
+		{
+			bool save = false;
+			n -= cell.integrate(n, dt, noise, [&](long, const PONI_x_t&) {
+				t += dt;
+				ck.step++;
+				save = (ckfile != NULL && ck.step % interval == 0);
+				return !save;
+			});
+			if (save)
+				checkpoint();
+		}
+	};
+
+
 	//
 	// STEADY STATE FOR PREDOMINANTLY REPRESSIVE INPUT (PREPATTERN CONDITION)
 	//
-	// set Gli input (constant)
-	// Here Gli is passed as two real numbers to the setEffector method
-	start.setEffector(0., 1.);
+	if (ck.phase == 0)
+	{
+		// set Gli input (constant)
+		// Here Gli is passed as two real numbers to the setEffector method
+		start.setEffector(0., 1.);
+
+		// simulate system for long time
+		STATS_START(STATS_PREPATTERN);
+		if (parareal > 0)
+		{
+			// as many steps as the loop below
+			long steps = 0;
+			for (; t < 0.; t += dt)
+				steps++;
+
+			Parareal pr(start, steps, dt);
+			pr.threads = parareal;
+			pr.slices = parareal;
+			start.setState(pr.run());
+			cerr << "parareal: " << pr.iterations() << " iterations on "
+				 << pr.slices << " slices\n";
+		}
+		run(start, 0.);
+		STATS_STOP(STATS_PREPATTERN);
+		ck.phase = 1;
+	}
+
+
+	//
+	// PATTERN FROM THE TABLE OF RESPONSES
+	//
+	if (table != NULL)
+	{
+		ResponseTable resp;
 
-	// simulate system for long time
-	for (double t = -1000.; t < 0.; t += dt) {
+		STATS_START(STATS_PATTERN);
+		if (!resp.load(table, start))
+		{
+			resp.build(start);
+			resp.save(table);
+		}
 
-		// evolve by a step dt (Euler integration)
-		// set second variable to 'true' to add noise
-		start.evolve(dt, noise);
+		for (x = 0.; x < 1.; x += dx)
+		{
+			grn = start;
+			grn.setEffector(gliGradient(x));
+			grn.setState(resp.lookup(gliGradient(x)(0)));
+			cout << x << "\t" << grn << "\n";
+		}
+		STATS_STOP(STATS_PATTERN);
+
+		cout.flush();
+		STATS_REPORT("PONIpattern");
+		return 0;
+	}
+
+
+	//
+	// ADAPTIVE LATTICE
+	//
+	if (adaptive > 0.)
+	{
+		map<double, PONI_x_t> cells;	// final state by position
+
+		// as many steps as the loop over the time of each cell below
+		long steps = 0;
+		for (double tc = 0.; tc < 300.; tc += dt)
+			steps++;
+
+		auto simulate = [&](double xc) {
+			grn = start;
+			grn.setEffector(gliGradient(xc));
+			grn.integrate(steps, dt, noise);
+			cells[xc] = grn.getState();
+		};
+		auto differ = [&](double a, double b) {
+			return (cells[a] - cells[b]).cwiseAbs().maxCoeff() > adaptive;
+		};
+
+		STATS_START(STATS_PATTERN);
+		vector<pair<double,double>> todo;
+		double xprev = 0.;
+		for (x = 0.; x < 1.; x += dx)
+		{
+			simulate(x);
+			if (x > 0.)
+				todo.push_back(make_pair(xprev, x));
+			xprev = x;
+		}
+
+		// bisect the intervals across which the state changes
+		vector<pair<double,double>> boundaries;
+		while (!todo.empty())
+		{
+			double a = todo.back().first, b = todo.back().second;
+			todo.pop_back();
+			if (!differ(a, b))
+				continue;
+			if (b - a <= dxMin)
+			{
+				boundaries.push_back(make_pair(a, b));
+				continue;
+			}
+			double m = .5*(a + b);
+			simulate(m);
+			todo.push_back(make_pair(m, b));
+			todo.push_back(make_pair(a, m));
+		}
+		STATS_STOP(STATS_PATTERN);
+
+		STATS_START(STATS_OUTPUT);
+		for (const auto& c : cells)
+		{
+			grn.setState(c.second);
+			grn.setEffector(gliGradient(c.first));
+			cout << c.first << "\t" << grn << "\n";
+		}
+
+		// steep (but continuous) transitions span several contiguous intervals
+		sort(boundaries.begin(), boundaries.end());
+		vector<pair<double,double>> merged;
+		for (const auto& bd : boundaries)
+		{
+			if (!merged.empty() && merged.back().second == bd.first)
+				merged.back().second = bd.second;
+			else
+				merged.push_back(bd);
+		}
+
+		cout << setprecision(9);
+		cout << "# " << cells.size() << " cells, boundaries (position, half-width):\n";
+		for (const auto& bd : merged)
+			cout << "# " << .5*(bd.first + bd.second)
+				 << "\t" << .5*(bd.second - bd.first) << "\n";
+		cout.flush();
+		STATS_STOP(STATS_OUTPUT);
+
+		STATS_REPORT("PONIpattern");
+		return 0;
+	}
+
+
+	//
+	// COUPLED CELLS
+	//
+	if (!couplings.empty() || ck.phase == 2)
+	{
+		vector<double> xs;
+		for (x = 0.; x < 1.; x += dx)
+			xs.push_back(x);
+		const int nc = xs.size();
+
+		// all the cells start from the prepattern, with the Gli of their position
+		PONIlattice lattice(start, nc);
+		if (ck.phase == 2)
+			lattice = ck.lattices[0];
+		else
+		{
+			vector<double> eff(2*nc);
+			for (int i = 0; i < nc; i++)
+			{
+				gli = gliGradient(xs[i]);
+				eff[i] = gli(0);
+				eff[nc + i] = gli(1);
+			}
+			lattice.setEffectors(eff.data());
+			for (const auto& c : couplings)
+				lattice.addCoupling(c.target, c.source, c.K, c.f);
+			t = 0.;
+			ck.phase = 2;
+		}
+		lattice.threads = threads;
+
+		// as many steps as the loop over the time of each cell below
+		long steps = 0;
+		for (double s = t; s < 300.; s += dt)
+			steps++;
+
+		// advance up to the next checkpoint at a time
+		STATS_START(STATS_PATTERN);
+		while (steps > 0)
+		{
+			long m = steps;
+			if (ckfile != NULL)
+				m = min(m, interval - ck.step % interval);
+			lattice.advance(m*dt, dt, noise);
+			for (long k = 0; k < m; k++)
+				t += dt;
+			ck.step += m;
+			steps -= m;
+			if (ckfile != NULL && ck.step % interval == 0)
+			{
+				ck.lattices.assign(1, lattice);
+				checkpoint();
+				ck.lattices.clear();
+			}
+		}
+		STATS_STOP(STATS_PATTERN);
+
+		STATS_START(STATS_OUTPUT);
+		for (int i = 0; i < nc; i++)
+		{
+			grn = start;
+			grn.setEffector(gliGradient(xs[i]));
+			grn.setState(lattice.getState(i));
+			cout << xs[i] << "\t" << grn << "\n";
+		}
+		cout.flush();
+		STATS_STOP(STATS_OUTPUT);
+
+		STATS_REPORT("PONIpattern");
+		return 0;
 	}
 
 
@@ -114,29 +507,42 @@ int main (int argc, char *argv[])
 	// SIMULATION WITH GRADIENT OF GLI
 	//
 	// loop over all cells (lattice points on a line)
-	for (double x = 0.; x < 1.; x += dx)
+	STATS_START(STATS_PATTERN);
+	for (; x < 1.; x += dx)
 	{
-		// make copies of 'start' at each position on the lattice
-		// all cells are equal initially
-		grn = start;
+		if (!inCell)
+		{
+			// make copies of 'start' at each position on the lattice
+			// all cells are equal initially
+			grn = start;
 
 
-		// set Gli constant in a space dependent manner (decreasing GliA, GliR = 1 - GliA)
-		// Here Gli is passed as a PONI_h_t variable (Vector2d object from Eigen)
-		grn.setEffector(gliGradient(x));
-		
-		for (double t = 0.; t < 300.; t += dt) {
-			// evolve by a step dt (Euler integration)
-			// set second variable to 'true' to add noise
-			grn.evolve(dt, noise);
+			// set Gli constant in a space dependent manner (decreasing GliA, GliR = 1 - GliA)
+			// Here Gli is passed as a PONI_h_t variable (Vector2d object from Eigen)
+			grn.setEffector(gliGradient(x));
+			t = 0.;
 		}
+		inCell = false;
+		
+		run(grn, 300.);
 
 		// print final pattern to stdout
+		STATS_STOP(STATS_PATTERN);
+		STATS_START(STATS_OUTPUT);
 		cout << x << "\t" << grn << "\n";
+		ck.lines++;
+		STATS_STOP(STATS_OUTPUT);
+		STATS_START(STATS_PATTERN);
 
 	}
+	STATS_STOP(STATS_PATTERN);
 
+	STATS_START(STATS_OUTPUT);
 	cout.flush();
+	STATS_STOP(STATS_OUTPUT);
+
+	// run report (to stderr), only when compiled with -DPONI_STATS
+	STATS_REPORT("PONIpattern");
 
 	return 0;
 
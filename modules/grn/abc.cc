@@ -0,0 +1,455 @@
+/******************************************************************************
+ *
+ *  abc.cc
+ *
+ *  Implementation of the ABC-SMC fitting of PONI parameters.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define ABC_CC
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/abc.h"
+
+using namespace std;
+
+
+/*
+ *    ####   #   #  #   #  #   #   ###   ####   #   #
+ *   #       #   #  ## ##  ## ##  #   #  #   #   # #
+ *    ###    #   #  # # #  # # #  #####  ####     #
+ *       #   #   #  #   #  #   #  #   #  #  #     #
+ *   ####     ###   #   #  #   #  #   #  #   #    #
+ */
+
+// same lattice, gradient and times as PONIpattern
+static const double patDt = .01;
+static const double patTpre = 1000.;
+static const double patT = 300.;
+static const double patDx = .05;        // coarse lattice
+static const double patDxMin = 1.e-3;   // resolution of the boundaries
+
+
+// lengths of the domains where Pax, Olig and Nkx are dominant
+static Vector3d domains (const PONI& cell)
+{
+    PONI start = cell;
+    start.setState(.95, .005, .005, .95);
+    start.setEffector(0., 1.);
+    for (double t = - patTpre; t < 0.; t += patDt)
+        start.evolve(patDt, false);
+
+    auto dominant = [&](double x) {
+        PONI c = start;
+        double g = exp(- x/0.15);
+        c.setEffector(g, 1. - g);
+        for (double t = 0.; t < patT; t += patDt)
+            c.evolve(patDt, false);
+        int i;
+        c.getState().head<3>().maxCoeff(&i);
+        return i;
+    };
+
+    Vector3d w = Vector3d::Zero();
+    int n = lround(1./patDx);
+    int dprev = dominant(0.);
+    double xprev = 0.;
+    for (int k = 1; k <= n; k++)
+    {
+        double a = (k - 1)*patDx, b = k*patDx;
+        int db = dominant(b);
+        if (db != dprev)
+        {
+            // bisection, keeping the dominant gene at a equal to dprev
+            while (b - a > patDxMin)
+            {
+                double m = .5*(a + b);
+                if (dominant(m) == dprev)
+                    a = m;
+                else
+                    b = m;
+            }
+            w(dprev) += .5*(a + b) - xprev;
+            xprev = .5*(a + b);
+        }
+        dprev = db;
+    }
+    w(dprev) += 1. - xprev;
+    return w;
+}
+
+
+vector<double> patternBoundaries (const PONI& cell)
+{
+    Vector3d w = domains(cell);
+    return {w(2), w(2) + w(1)};
+}
+
+
+vector<double> domainWidths (const PONI& cell)
+{
+    Vector3d w = domains(cell);
+    return {w(2), w(1), w(0)};
+}
+
+
+/*
+ *    ###   ####    ####
+ *   #   #  #   #  #
+ *   #####  ####   #
+ *   #   #  #   #  #
+ *   #   #  ####    ####
+ */
+
+ABCSMC::ABCSMC (const PONI& cell, ABC_summary_t stat, const vector<double>& data)
+    : model(cell), summary(stat), target(data)
+{
+    gen = -1;
+    eps = INFINITY;
+    sims = 0;
+    particles = 100;
+    alpha = .5;
+    threads = 1;
+    maxSims = 1000000;
+}
+
+
+void ABCSMC::addParameter (string name, double lo, double hi, bool log)
+{
+    if (!(hi > lo) || (log && !(lo > 0.)))
+    {
+        cout << "error: ABCSMC: invalid prior for \"" << name << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    // check the name (exits if invalid)
+    model.setParameters(name, .5*(lo + hi));
+    pars.push_back({name, lo, hi, log});
+}
+
+
+double ABCSMC::toU (int k, double v) const
+{
+    return pars[k].log ? std::log(v) : v;
+}
+
+double ABCSMC::fromU (int k, double u) const
+{
+    return pars[k].log ? exp(u) : u;
+}
+
+
+double ABCSMC::distance (const vector<double>& s) const
+{
+    if (s.size() != target.size())
+        return INFINITY;
+    double d = 0.;
+    for (unsigned i = 0; i < s.size(); i++)
+        d += (s[i] - target[i])*(s[i] - target[i]);
+    return sqrt(d);
+}
+
+
+// distances of the proposals, on 'threads' threads
+vector<double> ABCSMC::evaluate (const vector<vector<double>>& thetas) const
+{
+    int n = thetas.size();
+    vector<double> d(n);
+    atomic<int> next(0);
+
+    auto worker = [&]() {
+        PONI cell = model;
+        for (int i = next++; i < n; i = next++)
+        {
+            for (unsigned k = 0; k < pars.size(); k++)
+                cell.setParameters(pars[k].name, thetas[i][k]);
+            d[i] = distance(summary(cell));
+        }
+    };
+
+    int nt = max(1, min(threads, n));
+    vector<thread> pool;
+    for (int t = 1; t < nt; t++)
+        pool.push_back(thread(worker));
+    worker();
+    for (auto& t : pool)
+        t.join();
+
+    return d;
+}
+
+
+void ABCSMC::step ()
+{
+    int np = pars.size();
+    if (np == 0 || particles < 1)
+    {
+        cout << "error: ABCSMC: no parameters to fit\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // tolerance and kernel (in the space of the prior) of this generation
+    double epsNew = INFINITY;
+    vector<double> sigma(np, 0.), cum;
+    if (gen >= 0)
+    {
+        vector<double> ds;
+        for (const auto& p : pop)
+            ds.push_back(p.d);
+        sort(ds.begin(), ds.end());
+        epsNew = ds[(int) floor(alpha*(ds.size() - 1))];
+
+        for (int k = 0; k < np; k++)
+        {
+            double m = 0., v = 0.;
+            for (const auto& p : pop)
+                m += p.w * toU(k, p.theta[k]);
+            for (const auto& p : pop)
+                v += p.w * pow(toU(k, p.theta[k]) - m, 2);
+            // (not zero if the population has collapsed)
+            sigma[k] = max(sqrt(2.*v), 1.e-12*(toU(k, pars[k].hi) - toU(k, pars[k].lo)));
+        }
+
+        double c = 0.;
+        for (const auto& p : pop)
+            cum.push_back(c += p.w);
+    }
+
+    // propose in batches until 'particles' are accepted
+    vector<ABCParticle> next;
+    long n = 0;
+    while ((int) next.size() < particles)
+    {
+        // (all the proposals from the prior are accepted)
+        int nb = particles - (int) next.size();
+        if (gen >= 0)
+            nb = max(2*nb, 16);
+        vector<vector<double>> thetas(nb, vector<double>(np));
+
+        for (int i = 0; i < nb; i++)
+        {
+            bool inside;
+            do {
+                int j = -1;
+                double r[1];
+                if (gen >= 0)
+                {
+                    ranlxd(r, 1);
+                    j = lower_bound(cum.begin(), cum.end(), r[0]*cum.back())
+                        - cum.begin();
+                    j = min(j, (int) pop.size() - 1);
+                }
+                inside = true;
+                for (int k = 0; k < np; k++)
+                {
+                    double u, lo = toU(k, pars[k].lo), hi = toU(k, pars[k].hi);
+                    if (j < 0)
+                    {
+                        ranlxd(r, 1);
+                        u = lo + r[0]*(hi - lo);
+                    }
+                    else
+                    {
+                        gauss_dble(r, 1);
+                        u = toU(k, pop[j].theta[k]) + sigma[k]*r[0];
+                    }
+                    inside = inside && (u >= lo) && (u <= hi);
+                    thetas[i][k] = fromU(k, u);
+                }
+            } while (!inside);
+        }
+
+        vector<double> d = evaluate(thetas);
+        n += nb;
+
+        for (int i = 0; i < nb && (int) next.size() < particles; i++)
+            if (d[i] <= epsNew)
+                next.push_back({thetas[i], 1., d[i]});
+
+        if (n > maxSims && (int) next.size() < particles)
+        {
+            cout << "error: ABCSMC: acceptance too low at generation "
+                 << gen + 1 << " (epsilon " << epsNew << ")\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // importance weights (the prior is uniform in the space of the kernel)
+    if (gen >= 0)
+    {
+        for (auto& q : next)
+        {
+            double s = 0.;
+            for (const auto& p : pop)
+            {
+                double e = 0.;
+                for (int k = 0; k < np; k++)
+                    e += pow((toU(k, q.theta[k]) - toU(k, p.theta[k]))/sigma[k], 2);
+                s += p.w * exp(-.5*e);
+            }
+            q.w = 1./s;
+        }
+    }
+    double wsum = 0.;
+    for (const auto& q : next)
+        wsum += q.w;
+    for (auto& q : next)
+        q.w /= wsum;
+
+    pop.swap(next);
+    eps = epsNew;
+    sims += n;
+    gen++;
+}
+
+
+vector<double> ABCSMC::mean () const
+{
+    vector<double> m(pars.size(), 0.);
+    for (const auto& p : pop)
+        for (unsigned k = 0; k < pars.size(); k++)
+            m[k] += p.w * p.theta[k];
+    return m;
+}
+
+
+/*
+ *    ####   ###   #   #  #####
+ *   #      #   #  #   #  #
+ *    ###   #####  #   #  ####
+ *       #  #   #   # #   #
+ *   ####   #   #    #    #####
+ */
+
+void ABCSMC::write (const char* filename) const
+{
+    string tmp = string(filename) + ".tmp";
+    ofstream os(tmp.c_str(), ios::out | ios::trunc);
+    if (!os)
+    {
+        cout << "error: ABCSMC: cannot write \"" << tmp << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    os << setprecision(17);
+    os << "# generation " << gen << " epsilon " << eps
+       << " simulations " << sims << "\n";
+    os << "# parameters";
+    for (const auto& p : pars)
+        os << " " << p.name;
+    os << "\n";
+
+    vector<int> state(rlxd_size());
+    rlxd_get(state.data());
+    os << "# rng";
+    for (int s : state)
+        os << " " << s;
+    os << "\n";
+
+    for (const auto& p : pop)
+    {
+        os << p.w << "\t" << p.d;
+        for (double v : p.theta)
+            os << "\t" << v;
+        os << "\n";
+    }
+
+    os.close();
+    if (!os || rename(tmp.c_str(), filename) != 0)
+    {
+        cout << "error: ABCSMC: cannot write \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void ABCSMC::read (const char* filename)
+{
+    ifstream is(filename);
+    if (!is)
+    {
+        cout << "error: ABCSMC: cannot read \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // numbers are read with strtod, which accepts "inf"
+    auto number = [](const string& s) { return strtod(s.c_str(), NULL); };
+
+    string line, tok;
+    vector<int> state;
+    vector<ABCParticle> p;
+    int g = -1;
+    double e = INFINITY;
+    long n = 0;
+    bool namesOk = false;
+
+    while (getline(is, line))
+    {
+        istringstream ls(line);
+        vector<string> w;
+        while (ls >> tok)
+            w.push_back(tok);
+        if (w.empty())
+            continue;
+
+        if (w[0] == "#")
+        {
+            if (w.size() == 7 && w[1] == "generation")
+            {
+                g = atoi(w[2].c_str());
+                e = number(w[4]);
+                n = atol(w[6].c_str());
+            }
+            else if (w.size() > 1 && w[1] == "parameters")
+            {
+                namesOk = (w.size() == pars.size() + 2);
+                for (unsigned k = 0; namesOk && k < pars.size(); k++)
+                    namesOk = (w[k+2] == pars[k].name);
+            }
+            else if (w.size() > 1 && w[1] == "rng")
+            {
+                for (unsigned k = 2; k < w.size(); k++)
+                    state.push_back(atoi(w[k].c_str()));
+            }
+            continue;
+        }
+
+        if (w.size() != pars.size() + 2)
+        {
+            cout << "error: ABCSMC: invalid particle in \"" << filename << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        ABCParticle q;
+        q.w = number(w[0]);
+        q.d = number(w[1]);
+        for (unsigned k = 2; k < w.size(); k++)
+            q.theta.push_back(number(w[k]));
+        p.push_back(q);
+    }
+
+    if (g < 0 || !namesOk || p.empty() || (int) state.size() != rlxd_size())
+    {
+        cout << "error: ABCSMC: \"" << filename
+             << "\" is not a population of the same parameters\n";
+        exit(EXIT_FAILURE);
+    }
+
+    rlxd_reset(state.data());
+    pop.swap(p);
+    gen = g;
+    eps = e;
+    sims = n;
+}
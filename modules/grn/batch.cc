@@ -0,0 +1,725 @@
+/******************************************************************************
+ *
+ *  batch.cc
+ *
+ *  Implementation of the PONIbatch class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define BATCH_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <climits>
+#include "random.h"
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/schedule.h"
+
+using namespace std;
+
+
+// same as Hill (grnfunc.cc), inlined in the loops over the cells
+static inline double hill (double z)
+{
+    return z/(1.+z);
+}
+
+
+// parameters in the order of PONI::parameterNames
+enum { LC, LT, PPAX, POLI, PNKX, PIRX, GOLI, GNKX,
+       OLI_PAX, OLI_NKX, NKX_OLI, PAX_NKX, NKX_PAX,
+       IRX_OLI, OLI_IRX, IRX_NKX, NKX_IRX,
+       FA, CPOL, APAX, AOLI, ANKX, AIRX, DELTA, OMEGA };
+
+
+PONIbatch::PONIbatch (const PONI& cell, int ncells, double* state)
+    : par(cell), n(ncells)
+{
+    if (n < 1)
+    {
+        cout << "error: PONIbatch: the batch needs at least one cell\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if (state != NULL)
+        x = state;
+    else
+    {
+        own.resize(4*n);
+        x = own.data();
+        for (int i = 0; i < n; i++)
+            setState(i, cell.getState());
+    }
+
+    h.resize(2*n);
+    kO.resize(n);
+    kN.resize(n);
+    kP.resize(n);
+    kI.resize(n);
+    pcol.assign(PONI_NPAR, -1);
+    for (int k = 0; k < 4; k++)
+        lag[k] = 0;
+    dtDelay = 0.;
+    slots = 0;
+    stride = 0;
+    head = 0;
+    setEffector(cell.getEffector());
+}
+
+
+// copies own their state
+PONIbatch::PONIbatch (const PONIbatch& b)
+    : par(b.par), n(b.n), own(b.x, b.x + 4*b.n), h(b.h), kO(b.kO), kN(b.kN),
+      kP(b.kP), kI(b.kI), pcol(b.pcol), pc(b.pc), dtDelay(b.dtDelay),
+      slots(b.slots), stride(b.stride), head(b.head)
+{
+    x = own.data();
+    for (int k = 0; k < 4; k++)
+        lag[k] = b.lag[k];
+    copyHistory(b);
+}
+
+PONIbatch& PONIbatch::operator= (const PONIbatch& b)
+{
+    par = b.par;
+    n = b.n;
+    own.assign(b.x, b.x + 4*b.n);
+    x = own.data();
+    h = b.h;
+    kO = b.kO;
+    kN = b.kN;
+    kP = b.kP;
+    kI = b.kI;
+    pcol = b.pcol;
+    pc = b.pc;
+    for (int k = 0; k < 4; k++)
+        lag[k] = b.lag[k];
+    dtDelay = b.dtDelay;
+    slots = b.slots;
+    stride = b.stride;
+    head = b.head;
+    copyHistory(b);
+    return *this;
+}
+
+
+// the history starts on a cache line, whose offset in hist may differ
+void PONIbatch::copyHistory (const PONIbatch& b)
+{
+    hist.assign(b.hist.size(), 0.);
+    if (slots > 0)
+        copy(b.history(), b.history() + 4*slots*stride, history());
+}
+
+
+void PONIbatch::setState (int i, const PONI_x_t& xi)
+{
+    for (int k = 0; k < 4; k++)
+        x[k*n + i] = xi(k);
+}
+
+PONI_x_t PONIbatch::getState (int i) const
+{
+    PONI_x_t xi;
+    xi << x[i], x[n + i], x[2*n + i], x[3*n + i];
+    return xi;
+}
+
+
+void PONIbatch::setEffector (const PONI_h_t& eff)
+{
+    for (int i = 0; i < n; i++)
+    {
+        h[i] = eff(0);
+        h[n + i] = eff(1);
+    }
+    makePlan();
+}
+
+void PONIbatch::setEffectors (const double* eff)
+{
+    h.assign(eff, eff + 2*n);
+    makePlan();
+}
+
+
+/*
+ *    ####    ###   ####    ###   #   #  #####  #####  #####  ####    ####
+ *    #   #  #   #  #   #  #   #  ## ##  #        #    #      #   #  #
+ *    ####   #####  ####   #####  # # #  ####     #    ####   ####    ###
+ *    #      #   #  #  #   #   #  #   #  #        #    #      #  #       #
+ *    #      #   #  #   #  #   #  #   #  #####    #    #####  #   #  ####
+ */
+
+int PONIbatch::parameterIndex (const string& key) const
+{
+    const vector<string>& names = PONI::parameterNames();
+    int j = find(names.begin(), names.end(), key) - names.begin();
+    if (j == (int) names.size())
+    {
+        cout << "error: PONIbatch: invalid parameter name \"" << key << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    if (j == LC || j == LT)
+    {
+        cout << "error: PONIbatch: the scales lambdaConc and lambdaTime "
+             << "cannot be set per cell\n";
+        exit(EXIT_FAILURE);
+    }
+    return j;
+}
+
+
+PONIbatch::column PONIbatch::param (int j) const
+{
+    // members of PONI in the order of parameterNames
+    static double PONI::* const member[PONI_NPAR] = {
+        &PONI::lambdaConc, &PONI::lambdaTime,
+        &PONI::K_Pol_Pax, &PONI::K_Pol_Oli, &PONI::K_Pol_Nkx, &PONI::K_Pol_Irx,
+        &PONI::K_Gli_Oli, &PONI::K_Gli_Nkx,
+        &PONI::K_Oli_Pax, &PONI::K_Oli_Nkx, &PONI::K_Nkx_Oli,
+        &PONI::K_Pax_Nkx, &PONI::K_Nkx_Pax,
+        &PONI::K_Irx_Oli, &PONI::K_Oli_Irx, &PONI::K_Irx_Nkx, &PONI::K_Nkx_Irx,
+        &PONI::f_A, &PONI::C_Pol,
+        &PONI::alpha_Pax, &PONI::alpha_Oli, &PONI::alpha_Nkx, &PONI::alpha_Irx,
+        &PONI::delta, &PONI::Omega
+    };
+
+    column c;
+    if (pcol[j] < 0)
+    {
+        c.p = &(par.*member[j]);
+        c.inc = 0;
+    }
+    else
+    {
+        c.p = pc.data() + pcol[j]*n;
+        c.inc = 1;
+    }
+    return c;
+}
+
+
+//
+//  values in the units of the files, rescaled as in PONI::assignParameters
+//
+void PONIbatch::setParameters (const string& key, const double* values)
+{
+    const int j = parameterIndex(key);
+    const double lc = par.lambdaConc, lt = par.lambdaTime;
+
+    if (pcol[j] < 0)
+    {
+        pcol[j] = pc.size()/n;
+        pc.resize(pc.size() + n);
+    }
+    double* c = pc.data() + pcol[j]*n;
+    for (int i = 0; i < n; i++)
+    {
+        double v = values[i];
+        if (j >= PPAX && j <= NKX_IRX)
+            v = v / lc;
+        else if (j == CPOL)
+            v = v * lc;
+        else if (j >= APAX && j <= AIRX)
+            v = v * lc / lt;
+        else if (j == DELTA)
+            v = v / lt;
+        c[i] = v;
+    }
+
+    makePlan();
+}
+
+
+void PONIbatch::drawParameters (const string& key, int distribution, double cv)
+{
+    parameterIndex(key);
+    if (!(cv >= 0.))
+    {
+        cout << "error: PONIbatch: the spread of the parameters must be >= 0\n";
+        exit(EXIT_FAILURE);
+    }
+    const double v0 = par.getParameter(key);
+    vector<double> v(n);
+
+    if (distribution == BATCH_LOGNORMAL)
+    {
+        double s2 = log(1. + cv*cv);
+        double mu = log(v0) - s2/2., s = sqrt(s2);
+        gauss_dble(v.data(), n);
+        for (int i = 0; i < n; i++)
+            v[i] = exp(mu + s*v[i]);
+    }
+    else if (distribution == BATCH_UNIFORM)
+    {
+        ranlxd(v.data(), n);
+        for (int i = 0; i < n; i++)
+            v[i] = v0 * (1. + cv*(2.*v[i] - 1.));
+    }
+    else
+    {
+        cout << "error: PONIbatch: invalid distribution of the parameters\n";
+        exit(EXIT_FAILURE);
+    }
+
+    setParameters(key, v.data());
+}
+
+
+double PONIbatch::getParameter (const string& key, int i) const
+{
+    const int j = parameterIndex(key);
+    if (pcol[j] < 0)
+        return par.getParameter(key);
+
+    const double lc = par.lambdaConc, lt = par.lambdaTime;
+    double v = pc[pcol[j]*n + i];
+    if (j >= PPAX && j <= NKX_IRX)
+        v = v * lc;
+    else if (j == CPOL)
+        v = v / lc;
+    else if (j >= APAX && j <= AIRX)
+        v = v * lt / lc;
+    else if (j == DELTA)
+        v = v * lt;
+    return v;
+}
+
+
+//
+//  same operations as PONI::makePlan, for each cell
+//
+void PONIbatch::makePlan ()
+{
+    const PONI& p = par;
+
+    if (pc.empty())
+    {
+        for (int i = 0; i < n; i++)
+        {
+            double g;
+
+            g = 1. + p.f_A * p.K_Gli_Oli * h[i];
+            g /= 1. + p.K_Gli_Oli * (h[i] + h[n + i]);
+            kO[i] = p.K_Pol_Oli * p.C_Pol * g;
+
+            g = 1. + p.f_A * p.K_Gli_Nkx * h[i];
+            g /= 1. + p.K_Gli_Nkx * (h[i] + h[n + i]);
+            kN[i] = p.K_Pol_Nkx * p.C_Pol * g;
+        }
+        return;
+    }
+
+    const column pPax = param(PPAX), pOli = param(POLI), pNkx = param(PNKX),
+                 pIrx = param(PIRX), gOli = param(GOLI), gNkx = param(GNKX),
+                 fA = param(FA), cPol = param(CPOL);
+    for (int i = 0; i < n; i++)
+    {
+        double g;
+
+        kP[i] = pPax.at<true>(i) * cPol.at<true>(i);
+
+        g = 1. + fA.at<true>(i) * gOli.at<true>(i) * h[i];
+        g /= 1. + gOli.at<true>(i) * (h[i] + h[n + i]);
+        kO[i] = pOli.at<true>(i) * cPol.at<true>(i) * g;
+
+        g = 1. + fA.at<true>(i) * gNkx.at<true>(i) * h[i];
+        g /= 1. + gNkx.at<true>(i) * (h[i] + h[n + i]);
+        kN[i] = pNkx.at<true>(i) * cPol.at<true>(i) * g;
+
+        kI[i] = pIrx.at<true>(i) * cPol.at<true>(i);
+    }
+}
+
+
+/*
+ *    ####   #####  #       ###   #   #   ####
+ *    #   #  #      #      #   #   # #   #
+ *    #   #  ####   #      #####    #     ###
+ *    #   #  #      #      #   #    #        #
+ *    ####   #####  #####  #   #    #    ####
+ */
+
+void PONIbatch::setDelays (const PONI_x_t& tau, double dt)
+{
+    if (!(dt > 0.) || !(tau.minCoeff() >= 0.))
+    {
+        cout << "error: PONIbatch: the delays and the step must be >= 0 and > 0\n";
+        exit(EXIT_FAILURE);
+    }
+
+    int maxLag = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        lag[k] = lround(tau(k)/dt);
+        maxLag = max(maxLag, lag[k]);
+    }
+    dtDelay = dt;
+    head = 0;
+    if (maxLag == 0)
+    {
+        slots = 0;
+        hist.clear();
+        return;
+    }
+
+    // the current state is slot 0 when the first step is taken
+    slots = maxLag + 1;
+    stride = (n + 7)/8*8;
+    hist.assign(4*slots*stride + 8, 0.);
+    double* hb = history();
+    for (int s = 0; s < slots; s++)
+        for (int k = 0; k < 4; k++)
+            copy(x + k*n, x + (k + 1)*n, hb + (4*s + k)*stride);
+}
+
+
+// first element of hist on a cache line (64 bytes)
+double* PONIbatch::history ()
+{
+    uintptr_t a = (uintptr_t) hist.data();
+    return hist.data() + ((64 - a % 64) % 64)/sizeof(double);
+}
+
+const double* PONIbatch::history () const
+{
+    uintptr_t a = (uintptr_t) hist.data();
+    return hist.data() + ((64 - a % 64) % 64)/sizeof(double);
+}
+
+
+/*
+ *    #####  #   #   ###   #       #   #  #####
+ *    #      #   #  #   #  #       #   #  #
+ *    ####   #   #  #   #  #       #   #  ####
+ *    #       # #   #   #  #        # #   #
+ *    #####    #     ###   #####     #    #####
+ */
+
+//
+//  at least m gaussian numbers in g, in whole rows of the streams of ranlxdv
+//  (seeded from ranlxd if the calling thread has not initialized it); the
+//  spare numbers of the previous step are dropped
+//
+void PONIbatch::gaussians (int m)
+{
+    if (rlxdv_streams() == 0)
+    {
+        double u;
+        ranlxd(&u, 1);
+        rlxdv_init(BATCH_STREAMS, 1, 1 + (int) (u * (INT_MAX - BATCH_STREAMS)));
+    }
+
+    const int ns = rlxdv_streams();
+    const int rows = (m + ns - 1)/ns;
+    g.resize(rows*ns);
+    gauss_dblev(g.data(), rows);
+    gs.clear();
+}
+
+// four more rows of spare numbers (a multiple of 4)
+void PONIbatch::spares ()
+{
+    gs.resize(4*rlxdv_streams());
+    gauss_dblev(gs.data(), 4);
+}
+
+
+//
+//  Euler step of all the cells, with the operations of PONI::setProdR and
+//  PONI::evolve in the same order (deterministic steps are identical); only
+//  the repressions depend on the state (with delays, that of lag[k] steps
+//  before for the production of gene k). With het the parameters are read
+//  from their columns
+//
+template <bool het>
+void PONIbatch::step (double dt, bool stoch, const double* w)
+{
+    const PONI& p = par;
+
+    const column aPax = param(APAX), aOli = param(AOLI), aNkx = param(ANKX),
+                 aIrx = param(AIRX), delta = param(DELTA), omega = param(OMEGA);
+    const column kOP = param(OLI_PAX), kNP = param(NKX_PAX),
+                 kNO = param(NKX_OLI), kIO = param(IRX_OLI),
+                 kPN = param(PAX_NKX), kON = param(OLI_NKX), kIN = param(IRX_NKX),
+                 kOI = param(OLI_IRX), kNI = param(NKX_IRX);
+    const column kPax = het ? column{kP.data(), 1} : column{&p.plan.kPax, 0};
+    const column kIrx = het ? column{kI.data(), 1} : column{&p.plan.kIrx, 0};
+    const double sq0 = sqrt(dt/p.Omega);
+
+    double* x0 = x;
+    double* x1 = x + n;
+    double* x2 = x + 2*n;
+    double* x3 = x + 3*n;
+    const double* kOli = kO.data();
+    const double* kNkx = kN.data();
+
+    // regulators of each gene: the current state, or the one lag[k] steps
+    // before (the current state is stored in the ring first)
+    const double* xr[4][4];
+    for (int k = 0; k < 4; k++)
+        for (int l = 0; l < 4; l++)
+            xr[k][l] = x + l*n;
+    if (slots > 0)
+    {
+        if (fabs(dt - dtDelay) > 1.e-12*dtDelay)
+        {
+            cout << "error: PONIbatch: the step differs from that of the delays\n";
+            exit(EXIT_FAILURE);
+        }
+        double* hb = history();
+        int s = head % slots;
+        for (int l = 0; l < 4; l++)
+            copy(x + l*n, x + (l + 1)*n, hb + (4*s + l)*stride);
+        for (int k = 0; k < 4; k++)
+            if (lag[k] > 0)
+            {
+                int sk = (s - lag[k] % slots + slots) % slots;
+                for (int l = 0; l < 4; l++)
+                    xr[k][l] = hb + (4*sk + l)*stride;
+            }
+        head++;
+    }
+    const double *rP1 = xr[0][1], *rP2 = xr[0][2];
+    const double *rO2 = xr[1][2], *rO3 = xr[1][3];
+    const double *rN0 = xr[2][0], *rN1 = xr[2][1], *rN3 = xr[2][3];
+    const double *rI1 = xr[3][1], *rI2 = xr[3][2];
+
+    if (stoch && w == NULL)
+        gaussians(4*n);
+    int is = 0;         // next spare number
+
+    STATS_ADD(steps, n);
+    STATS_ADD(prodR, n);
+    for (int i = 0; i < n; i++)
+    {
+        double a1, a2, a3, r[4];
+
+        // Pax
+        a1 = 1./(1. + kOP.at<het>(i) * rP1[i]);
+        a1 *= a1;
+        a2 = 1./(1. + kNP.at<het>(i) * rP2[i]);
+        a2 *= a2;
+        r[0] = aPax.at<het>(i) * hill(kPax.at<het>(i) * a1 * a2);
+
+        // Olig
+        a1 = 1./(1. + kNO.at<het>(i) * rO2[i]);
+        a1 *= a1;
+        a2 = 1./(1. + kIO.at<het>(i) * rO3[i]);
+        a2 *= a2;
+        r[1] = aOli.at<het>(i) * hill(kOli[i] * a1 * a2);
+
+        // Nkx
+        a1 = 1./(1. + kPN.at<het>(i) * rN0[i]);
+        a1 *= a1;
+        a2 = 1./(1. + kON.at<het>(i) * rN1[i]);
+        a2 *= a2;
+        a3 = 1./(1. + kIN.at<het>(i) * rN3[i]);
+        a3 *= a3;
+        r[2] = aNkx.at<het>(i) * hill(kNkx[i] * a1 * a2 * a3);
+
+        // Irx
+        a1 = 1./(1. + kOI.at<het>(i) * rI1[i]);
+        a1 *= a1;
+        a2 = 1./(1. + kNI.at<het>(i) * rI2[i]);
+        a2 *= a2;
+        r[3] = aIrx.at<het>(i) * hill(kIrx.at<het>(i) * a1 * a2);
+
+        const double d = delta.at<het>(i);
+        double xi[4] = {x0[i], x1[i], x2[i], x3[i]}, xpp[4];
+        for (int k = 0; k < 4; k++)
+            xpp[k] = xi[k] + (r[k] - d * xi[k]) * dt;
+
+        if (stoch)
+        {
+            const double sq = het ? sqrt(dt/omega.at<het>(i)) : sq0;
+            double s[4], xp[4];
+            for (int k = 0; k < 4; k++)
+                s[k] = sqrt(r[k] + d * xi[k]);
+
+            // given numbers: negative levels are set to zero
+            if (w != NULL)
+            {
+                const double* wi = w + 4*i;
+                for (int k = 0; k < 4; k++)
+                    xpp[k] = max(0., xpp[k] + sq * (s[k] * wi[k]));
+                x0[i] = xpp[0];
+                x1[i] = xpp[1];
+                x2[i] = xpp[2];
+                x3[i] = xpp[3];
+                continue;
+            }
+
+            // the block of numbers for the first draw, redraws one by one
+            double* gi = g.data() + 4*i;
+            for (;;)
+            {
+                for (int k = 0; k < 4; k++)
+                    xp[k] = xpp[k] + sq * (s[k] * gi[k]);
+                if (xp[0] >= 0. && xp[1] >= 0. && xp[2] >= 0. && xp[3] >= 0.)
+                    break;
+                STATS_ADD(redraws, 1);
+                if (is == (int) gs.size())
+                {
+                    spares();
+                    is = 0;
+                }
+                for (int k = 0; k < 4; k++)
+                    gi[k] = gs[is + k];
+                is += 4;
+            }
+            for (int k = 0; k < 4; k++)
+                xpp[k] = xp[k];
+        }
+
+        x0[i] = xpp[0];
+        x1[i] = xpp[1];
+        x2[i] = xpp[2];
+        x3[i] = xpp[3];
+    }
+}
+
+
+void PONIbatch::evolve (double dt, bool stoch)
+{
+    if (pc.empty())
+        step<false>(dt, stoch, NULL);
+    else
+        step<true>(dt, stoch, NULL);
+}
+
+
+void PONIbatch::evolve (double dt, const double* w)
+{
+    if (pc.empty())
+        step<false>(dt, true, w);
+    else
+        step<true>(dt, true, w);
+}
+
+
+void PONIbatch::advance (double T, double dt, bool stoch)
+{
+    long steps = lround(T/dt);
+    for (long s = 0; s < steps; s++)
+        evolve(dt, stoch);
+}
+
+
+void PONIbatch::advance (double T, double dt, bool stoch, const Schedule& s, double t0)
+{
+    long steps = lround(T/dt);
+    long k = 0;
+    while (k < steps)
+    {
+        // the plan is rebuilt once per constant segment
+        setEffector(s.at(t0 + k*dt));
+        long m = min(s.stepsInSegment(t0, dt, k), steps - k);
+        for (long j = 0; j < m; j++)
+            evolve(dt, stoch);
+        k += m;
+    }
+}
+
+
+/*
+ *     ####   ###   #   #  #####
+ *    #      #   #  #   #  #
+ *     ###   #####  #   #  ####
+ *        #  #   #   # #   #
+ *    ####   #   #    #    #####
+ */
+
+//  Write the batch in binary form: parameters (PONI::write), state and
+//  effectors of the cells, per-cell parameters, delays and their history
+void PONIbatch::write (ostream& os) const
+{
+    int ncol = pc.size()/n;
+
+    os.write((const char*) &n, sizeof(int));
+    par.write(os);
+    os.write((const char*) x, 4*n*sizeof(double));
+    os.write((const char*) h.data(), 2*n*sizeof(double));
+
+    os.write((const char*) pcol.data(), PONI_NPAR*sizeof(int));
+    os.write((const char*) &ncol, sizeof(int));
+    os.write((const char*) pc.data(), pc.size()*sizeof(double));
+
+    os.write((const char*) lag, 4*sizeof(int));
+    os.write((const char*) &dtDelay, sizeof(double));
+    os.write((const char*) &slots, sizeof(int));
+    os.write((const char*) &head, sizeof(long));
+    const double* hb = history();
+    for (int r = 0; r < 4*slots; r++)
+        os.write((const char*) (hb + r*stride), n*sizeof(double));
+}
+
+
+//  Read what has been written by PONIbatch::write (the state is then owned
+//  by the batch)
+void PONIbatch::read (istream& is)
+{
+    int m = 0, ncol = -1;
+
+    is.read((char*) &m, sizeof(int));
+    if (!is || m < 1)
+    {
+        cout << "error: read (PONIbatch): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    n = m;
+    par.read(is);
+
+    own.resize(4*n);
+    x = own.data();
+    h.resize(2*n);
+    kO.resize(n);
+    kN.resize(n);
+    kP.resize(n);
+    kI.resize(n);
+    is.read((char*) x, 4*n*sizeof(double));
+    is.read((char*) h.data(), 2*n*sizeof(double));
+
+    pcol.resize(PONI_NPAR);
+    is.read((char*) pcol.data(), PONI_NPAR*sizeof(int));
+    is.read((char*) &ncol, sizeof(int));
+    if (!is || ncol < 0 || ncol > PONI_NPAR)
+    {
+        cout << "error: read (PONIbatch): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    pc.resize(ncol*n);
+    is.read((char*) pc.data(), pc.size()*sizeof(double));
+
+    is.read((char*) lag, 4*sizeof(int));
+    is.read((char*) &dtDelay, sizeof(double));
+    is.read((char*) &slots, sizeof(int));
+    is.read((char*) &head, sizeof(long));
+    if (!is || slots < 0 || head < 0)
+    {
+        cout << "error: read (PONIbatch): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    stride = (slots > 0) ? (n + 7)/8*8 : 0;
+    hist.assign(slots > 0 ? 4*slots*stride + 8 : 0, 0.);
+    double* hb = history();
+    for (int r = 0; r < 4*slots; r++)
+        is.read((char*) (hb + r*stride), n*sizeof(double));
+
+    if (!is)
+    {
+        cout << "error: read (PONIbatch): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    makePlan();
+}
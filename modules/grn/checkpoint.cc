@@ -0,0 +1,202 @@
+/******************************************************************************
+ *
+ *  checkpoint.cc
+ *  
+ *  Implementation of the checkpoint of a simulation.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define CHECKPOINT_CC
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/lattice.h"
+#include "grn/checkpoint.h"
+
+using namespace std;
+
+static const char magic[8] = {'P','O','N','I','C','K','P','2'};
+static const char magic1[8] = {'P','O','N','I','C','K','P','1'};
+
+
+Checkpoint::Checkpoint ()
+{
+    phase = 0;
+    step = 0;
+    lines = 0;
+    t = 0.;
+    rng = false;
+}
+
+
+void Checkpoint::write (const char* filename) const
+{
+    string tmp = string(filename) + ".tmp";
+    ofstream os(tmp.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!os)
+    {
+        cout << "error: Checkpoint: cannot write \"" << tmp << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    int irng = rng;
+    int nloop = loop.size();
+    int ncells = cells.size();
+    int nbatches = batches.size();
+    int nlattices = lattices.size();
+
+    os.write(magic, 8);
+    os.write((const char*) &phase, sizeof(int));
+    os.write((const char*) &irng, sizeof(int));
+    os.write((const char*) &step, sizeof(long));
+    os.write((const char*) &lines, sizeof(long));
+    os.write((const char*) &t, sizeof(double));
+    os.write((const char*) &nloop, sizeof(int));
+    if (nloop > 0)
+        os.write((const char*) loop.data(), nloop*sizeof(double));
+
+    if (rng)
+    {
+        vector<int> state(rlxd_size());
+        rlxd_get(state.data());
+        os.write((const char*) state.data(), state.size()*sizeof(int));
+
+        int nv = (rlxdv_streams() > 0) ? rlxdv_size() : 0;
+        state.resize(nv);
+        if (nv > 0)
+            rlxdv_get(state.data());
+        os.write((const char*) &nv, sizeof(int));
+        os.write((const char*) state.data(), nv*sizeof(int));
+    }
+
+    os.write((const char*) &ncells, sizeof(int));
+    for (const auto& c : cells)
+        c.write(os);
+    os.write((const char*) &nbatches, sizeof(int));
+    for (const auto& b : batches)
+        b.write(os);
+    os.write((const char*) &nlattices, sizeof(int));
+    for (const auto& l : lattices)
+        l.write(os);
+
+    os.close();
+    if (!os || rename(tmp.c_str(), filename) != 0)
+    {
+        cout << "error: Checkpoint: cannot write \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+void Checkpoint::read (const char* filename)
+{
+    ifstream is(filename, ios::in | ios::binary);
+    char m[8];
+    if (!is || !is.read(m, 8) || (memcmp(m, magic, 8) != 0 && memcmp(m, magic1, 8) != 0))
+    {
+        cout << "error: Checkpoint: \"" << filename
+             << "\" is not a checkpoint file\n";
+        exit(EXIT_FAILURE);
+    }
+
+    const bool v1 = (memcmp(m, magic1, 8) == 0);
+    int irng = 0, nloop = 0, ncells = 0, nbatches = 0, nlattices = 0;
+
+    is.read((char*) &phase, sizeof(int));
+    is.read((char*) &irng, sizeof(int));
+    is.read((char*) &step, sizeof(long));
+    is.read((char*) &lines, sizeof(long));
+    is.read((char*) &t, sizeof(double));
+    is.read((char*) &nloop, sizeof(int));
+    if (!is || nloop < 0 || nloop > 1024)
+    {
+        cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    loop.resize(nloop);
+    if (nloop > 0)
+        is.read((char*) loop.data(), nloop*sizeof(double));
+
+    rng = irng;
+    if (rng)
+    {
+        vector<int> state(rlxd_size());
+        is.read((char*) state.data(), state.size()*sizeof(int));
+        if (!is)
+        {
+            cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        rlxd_reset(state.data());
+
+        int nv = 0;
+        if (!v1)
+            is.read((char*) &nv, sizeof(int));
+        if (!is || nv < 0 || nv > 6 + 100*RLXDV_MAX)
+        {
+            cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        if (nv > 0)
+        {
+            state.resize(nv);
+            is.read((char*) state.data(), nv*sizeof(int));
+            if (!is)
+            {
+                cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+                exit(EXIT_FAILURE);
+            }
+            rlxdv_reset(state.data());
+        }
+    }
+
+    is.read((char*) &ncells, sizeof(int));
+    if (!is || ncells < 0)
+    {
+        cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    cells.assign(ncells, PONI());
+    for (auto& c : cells)
+        c.read(is);
+
+    if (!v1)
+    {
+        is.read((char*) &nbatches, sizeof(int));
+        if (!is || nbatches < 0)
+        {
+            cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        batches.assign(nbatches, PONIbatch(PONI(), 1));
+        for (auto& b : batches)
+            b.read(is);
+
+        is.read((char*) &nlattices, sizeof(int));
+        if (!is || nlattices < 0)
+        {
+            cout << "error: Checkpoint: corrupted file \"" << filename << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        lattices.assign(nlattices, PONIlattice(PONI(), 1));
+        for (auto& l : lattices)
+            l.read(is);
+    }
+    else
+    {
+        batches.clear();
+        lattices.clear();
+    }
+
+    is.close();
+}
@@ -0,0 +1,216 @@
+/******************************************************************************
+ *
+ *  continuation.cc
+ *
+ *  Implementation of the pseudo-arclength continuation of PONI fixed points.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define CONTINUATION_CC
+
+#include <iostream>
+#include <cmath>
+#include <vector>
+// the Householder reflections of EigenSolver (Eigen 3.4) give a spurious
+// -Wmaybe-uninitialized in TriangularMatrixVector.h
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <Eigen/Dense>
+#pragma GCC diagnostic pop
+#include "grn/poni.h"
+#include "grn/continuation.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+Continuation::Continuation (const PONI& net)
+    : grn(net)
+{
+    hR << 0., 1.;
+    hA << 1., 0.;
+    ds = 1.e-2;
+    dsMin = 1.e-8;
+    dsMax = 5.e-2;
+    tol = 1.e-10;
+    maxIter = 12;
+    maxSteps = 20000;
+    gMin = 0.;
+    gMax = 1.;
+}
+
+Continuation::Continuation (const PONI& net, PONI_h_t repressive, PONI_h_t activating)
+    : Continuation(net)
+{
+    hR = repressive;
+    hA = activating;
+}
+
+
+PONI_h_t Continuation::effector (double g) const
+{
+    return (1. - g) * hR + g * hA;
+}
+
+
+PONI_x_t Continuation::F (const PONI_x_t& x, double g)
+{
+    grn.setState(x);
+    grn.setEffector(effector(g));
+    return grn.getDrift();
+}
+
+PONI_J_t Continuation::Jx (const PONI_x_t& x, double g)
+{
+    grn.setState(x);
+    grn.setEffector(effector(g));
+    return grn.getJacobian();
+}
+
+// derivative of the drift w.r.t. g (central difference)
+PONI_x_t Continuation::Fg (const PONI_x_t& x, double g)
+{
+    const double eps = 1.e-7;
+    return (F(x, g + eps) - F(x, g - eps))/(2.*eps);
+}
+
+
+bool Continuation::steadyState (double g, PONI_x_t& x)
+{
+    grn.setState(x);
+    grn.setEffector(effector(g));
+    for (double t = 0.; t < 1000.; t += .01)
+        grn.evolve(.01, false);
+    x = grn.getState();
+
+    for (int it = 0; it < maxIter; it++)
+    {
+        PONI_x_t f = F(x, g);
+        if (f.norm() < tol)
+            return true;
+        x -= Jx(x, g).partialPivLu().solve(f);
+    }
+    return F(x, g).norm() < 1.e3*tol;
+}
+
+
+//
+//  unit tangent to the branch at y, oriented as 'prev'
+//
+Continuation::y_t Continuation::tangent (const y_t& y, const y_t& prev)
+{
+    PONI_x_t x = y.head<4>();
+    Matrix<double,5,5> A;
+    A.topLeftCorner<4,4>() = Jx(x, y(4));
+    A.topRightCorner<4,1>() = Fg(x, y(4));
+    A.bottomRows<1>() = prev.transpose();
+
+    y_t rhs = y_t::Zero();
+    rhs(4) = 1.;
+    y_t t = A.partialPivLu().solve(rhs);
+    t.normalize();
+    if (t.dot(prev) < 0.)
+        t = -t;
+    return t;
+}
+
+
+//
+//  Newton corrector on F(y) = 0 and t.(y - yp) = 0
+//
+bool Continuation::correct (y_t& y, const y_t& t, const y_t& yp)
+{
+    y = yp;
+    for (int it = 0; it < maxIter; it++)
+    {
+        PONI_x_t x = y.head<4>();
+        y_t res;
+        res.head<4>() = F(x, y(4));
+        res(4) = t.dot(y - yp);
+        if (res.norm() < tol)
+            return true;
+
+        Matrix<double,5,5> A;
+        A.topLeftCorner<4,4>() = Jx(x, y(4));
+        A.topRightCorner<4,1>() = Fg(x, y(4));
+        A.bottomRows<1>() = t.transpose();
+        y -= A.partialPivLu().solve(res);
+
+        if (!y.allFinite())
+            return false;
+    }
+    return false;
+}
+
+
+BifPoint Continuation::point (const y_t& y, bool fold)
+{
+    BifPoint p;
+    p.g = y(4);
+    p.x = y.head<4>();
+    EigenSolver<PONI_J_t> es(Jx(p.x, p.g), false);
+    p.lambda = es.eigenvalues().real().maxCoeff();
+    p.stable = (p.lambda < 0.);
+    p.fold = fold;
+    return p;
+}
+
+
+vector<BifPoint> Continuation::branch (double g, PONI_x_t x, int dir)
+{
+    vector<BifPoint> br;
+
+    y_t y, t, yn, tn;
+    y.head<4>() = x;
+    y(4) = g;
+
+    y_t prev = y_t::Zero();
+    prev(4) = (dir < 0) ? -1. : 1.;
+    t = tangent(y, prev);
+    br.push_back(point(y, false));
+
+    double h = ds;
+    for (int step = 0; step < maxSteps; step++)
+    {
+        if (!correct(yn, t, y + h*t))
+        {
+            h /= 2.;
+            if (h < dsMin)
+                break;
+            continue;
+        }
+        tn = tangent(yn, t);
+
+        // fold between y and yn: secant iterations on the g-component
+        // of the tangent, as a function of the step along t
+        if (t(4) * tn(4) < 0.)
+        {
+            double a = 0., b = h, ta = t(4), tb = tn(4);
+            y_t yf = yn, tf = tn;
+            for (int it = 0; it < 30 && fabs(tf(4)) > 1.e-9; it++)
+            {
+                double c = b - tb*(b - a)/(tb - ta);
+                if (!correct(yf, t, y + c*t))
+                    break;
+                tf = tangent(yf, t);
+                a = b; ta = tb;
+                b = c; tb = tf(4);
+            }
+            br.push_back(point(yf, true));
+        }
+
+        y = yn;
+        t = tn;
+        if (y(4) < gMin || y(4) > gMax || (y.head<4>().array() < 0.).any())
+            break;
+
+        br.push_back(point(y, false));
+
+        // adapt the step
+        h = min(1.5*h, dsMax);
+    }
+
+    return br;
+}
@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ *  dssa.cc
+ *
+ *  Implementation of the PONIdssa class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define DSSA_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include "random.h"
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/dssa.h"
+
+using namespace std;
+
+
+PONIdssa::PONIdssa (const PONI& cell, const PONI_x_t& delays)
+    : c(cell), tau(delays), t(0.)
+{
+    if (!(tau.minCoeff() >= 0.))
+    {
+        cout << "error: PONIdssa: the delays must be >= 0\n";
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < 4; k++)
+        ring[k].resize(64);
+    events = 0;
+    setState(cell.getState());
+}
+
+
+//
+//  the productions initiated in the delay before are drawn with the
+//  propensities of the new state (constant history)
+//
+void PONIdssa::setState (const PONI_x_t& x)
+{
+    for (int k = 0; k < 4; k++)
+    {
+        cnt[k] = lround(c.Omega * x(k));
+        c.x(k) = cnt[k] / c.Omega;
+        first[k] = 0;
+        count[k] = 0;
+    }
+
+    c.setProdR();
+    for (int k = 0; k < 4; k++)
+    {
+        const double a = c.Omega * c.prodR(k);
+        if (!(tau(k) > 0.) || !(a > 0.))
+            continue;
+        double u, ti = t - tau(k);
+        for (;;)
+        {
+            ranlxd(&u, 1);
+            ti -= log(1. - u)/a;
+            if (ti >= t)
+                break;
+            push(k, ti + tau(k));
+        }
+    }
+}
+
+
+void PONIdssa::push (int k, double tc)
+{
+    vector<double>& r = ring[k];
+    const int cap = r.size();
+    if (count[k] == cap)
+    {
+        // unwrap into a buffer twice as large
+        vector<double> bigger(2*cap);
+        for (int j = 0; j < cap; j++)
+            bigger[j] = r[(first[k] + j) & (cap - 1)];
+        r.swap(bigger);
+        first[k] = 0;
+    }
+    r[(first[k] + count[k]) & (r.size() - 1)] = tc;
+    count[k]++;
+}
+
+
+void PONIdssa::advance (double T)
+{
+    const double Omega = c.Omega, delta = c.delta;
+    const double tEnd = t + T;
+
+    c.setProdR();
+    for (;;)
+    {
+        double a[8], a0 = 0.;
+        for (int k = 0; k < 4; k++)
+        {
+            a[2*k] = Omega * c.prodR(k);
+            a[2*k+1] = delta * cnt[k];
+            a0 += a[2*k] + a[2*k+1];
+        }
+
+        // earliest completion
+        int kc = -1;
+        double tc = INFINITY;
+        for (int k = 0; k < 4; k++)
+            if (count[k] > 0 && ring[k][first[k]] < tc)
+            {
+                kc = k;
+                tc = ring[k][first[k]];
+            }
+
+        double u[2];
+        ranlxd(u, 2);
+        double tn = (a0 > 0.) ? t - log(1. - u[0])/a0 : INFINITY;
+
+        if (tc <= tn)
+        {
+            if (tc > tEnd)
+                break;
+            t = tc;
+            first[kc] = (first[kc] + 1) & (ring[kc].size() - 1);
+            count[kc]--;
+            cnt[kc]++;
+        }
+        else
+        {
+            if (tn > tEnd)
+                break;
+            t = tn;
+
+            double s = u[1] * a0;
+            int j = 0;
+            while (j < 7 && (s -= a[j]) >= 0.)
+                j++;
+            while (a[j] == 0.)      // rounding at the end of the sum
+                j--;
+            int k = j/2;
+            if (j % 2 == 1)
+                cnt[k]--;
+            else if (tau(k) > 0.)
+            {
+                push(k, t + tau(k));
+                events++;
+                continue;           // the state does not change
+            }
+            else
+                cnt[k]++;
+        }
+
+        events++;
+        STATS_ADD(steps, 1);
+        for (int k = 0; k < 4; k++)
+            c.x(k) = cnt[k] / Omega;
+        c.setProdR();
+    }
+    t = tEnd;
+}
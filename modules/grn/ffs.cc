@@ -0,0 +1,292 @@
+/******************************************************************************
+ *
+ *  ffs.cc
+ *
+ *  Implementation of the forward flux sampling of PONI switching.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define FFS_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/ffs.h"
+
+using namespace std;
+
+
+//
+//  run tasks 0...n-1 on new threads (the generator of the calling thread
+//  is not touched)
+//
+static void parallel (int n, int threads, function<void(int)> task)
+{
+    atomic<int> next(0);
+    auto worker = [&]() {
+        for (int k = next++; k < n; k = next++)
+            task(k);
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < max(1, min(threads, n)); t++)
+        pool.push_back(thread(worker));
+    for (auto& t : pool)
+        t.join();
+}
+
+
+FFS::FFS (const PONI& cell, FFS_order_t order, const vector<double>& interfaces)
+    : start(cell), lambda(order), iface(interfaces)
+{
+    for (unsigned i = 1; i < iface.size(); i++)
+        if (!(iface[i] > iface[i-1]))
+        {
+            cout << "error: FFS: the interfaces must be increasing\n";
+            exit(EXIT_FAILURE);
+        }
+    if (iface.size() < 2)
+    {
+        cout << "error: FFS: at least two interfaces are needed\n";
+        exit(EXIT_FAILURE);
+    }
+
+    lambdaA = NAN;
+    dt = .01;
+    walkers = 8;
+    points = 1000;
+    trials = 1000;
+    stride = 10;
+    maxSteps = 10000000;
+    threads = 1;
+    seed = 1;
+    phi = 0.;
+}
+
+
+void FFS::stage0 ()
+{
+    const double lA = lambdaA, l0 = iface[0], lB = iface.back();
+
+    vector<vector<crossing>> found(walkers);
+    vector<double> time(walkers, 0.);
+
+    parallel(walkers, threads, [&](int w) {
+        rlxd_init(1, seed + w);
+
+        int target = points/walkers + (w < points % walkers);
+        PONI c = start;
+        bool inA = (lambda(c.getState()) < lA);
+        FFS_path_t seg;
+        vector<double> ts;
+        double tseg = 0.;
+        long idle = 0;      // steps since the last crossing
+
+        while ((int) found[w].size() < target && idle < maxSteps)
+        {
+            if (idle % stride == 0)
+            {
+                seg.push_back(c.getState());
+                ts.push_back(tseg);
+            }
+            c.evolve(dt, true);
+            time[w] += dt;
+            tseg += dt;
+            idle++;
+
+            double l = lambda(c.getState());
+            if (l < lA)
+            {
+                inA = true;
+                seg.clear();
+                ts.clear();
+                tseg = 0.;
+            }
+            else if (inA && l >= l0)
+            {
+                seg.push_back(c.getState());
+                ts.push_back(tseg);
+                found[w].push_back({c, -1, seg, ts});
+                inA = false;
+                idle = 0;
+            }
+
+            // back to the initial cell from B
+            if (l >= lB)
+            {
+                c = start;
+                inA = (lambda(c.getState()) < lA);
+                seg.clear();
+                ts.clear();
+                tseg = 0.;
+            }
+        }
+    });
+
+    cross.assign(1, vector<crossing>());
+    double T = 0.;
+    for (int w = 0; w < walkers; w++)
+    {
+        cross[0].insert(cross[0].end(), found[w].begin(), found[w].end());
+        T += time[w];
+    }
+    phi = cross[0].size()/T;
+}
+
+
+void FFS::stage (int i)
+{
+    const double lA = lambdaA, li = iface[i];
+    const vector<crossing>& prev = cross[i-1];
+    const int np = prev.size();
+    const int task0 = walkers + (i - 1)*trials;
+
+    vector<char> success(trials, 0), timeout(trials, 0);
+    vector<crossing> found(trials);
+
+    parallel(trials, threads, [&](int k) {
+        rlxd_init(1, seed + task0 + k);
+
+        double r[1];
+        ranlxd(r, 1);
+        int j = min((int) (r[0]*np), np - 1);
+
+        crossing& q = found[k];
+        q.cell = prev[j].cell;
+        q.parent = j;
+
+        double tseg = 0.;
+        bool back = false;      // back to A
+        for (long s = 0; s < maxSteps && !back; s++)
+        {
+            if (s % stride == 0)
+            {
+                q.path.push_back(q.cell.getState());
+                q.ts.push_back(tseg);
+            }
+            q.cell.evolve(dt, true);
+            tseg += dt;
+
+            double l = lambda(q.cell.getState());
+            if (l >= li)
+            {
+                q.path.push_back(q.cell.getState());
+                q.ts.push_back(tseg);
+                success[k] = 1;
+                return;
+            }
+            back = (l < lA);
+        }
+        timeout[k] = !back;
+        q.path.clear();
+        q.ts.clear();
+    });
+
+    cross.push_back(vector<crossing>());
+    long nf = 0;
+    for (int k = 0; k < trials; k++)
+    {
+        if (success[k])
+            cross[i].push_back(found[k]);
+        nf += timeout[k];
+    }
+    prob.push_back((double) cross[i].size()/trials);
+    fails.push_back(nf);
+}
+
+
+void FFS::run ()
+{
+    if (std::isnan(lambdaA))
+        lambdaA = iface[0];
+    if (lambdaA > iface[0] || walkers < 1 || points < 1 || trials < 1 || stride < 1)
+    {
+        cout << "error: FFS: invalid settings\n";
+        exit(EXIT_FAILURE);
+    }
+
+    prob.clear();
+    fails.clear();
+
+    stage0();
+    if (cross[0].empty())
+    {
+        cout << "error: FFS: no crossing of the first interface "
+             << "(lambda_0 = " << iface[0] << ")\n";
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned i = 1; i < iface.size(); i++)
+    {
+        stage(i);
+        if (cross[i].empty())
+        {
+            // no path reaches the next interfaces: the rate is zero (within
+            // the statistics of this run)
+            for (unsigned k = i + 1; k < iface.size(); k++)
+                prob.push_back(0.);
+            break;
+        }
+    }
+}
+
+
+double FFS::rate () const
+{
+    double k = phi;
+    for (double p : prob)
+        k *= p;
+    return k;
+}
+
+
+vector<FFS_path_t> FFS::paths (vector<vector<double>>* times) const
+{
+    vector<FFS_path_t> all;
+    if (times != NULL)
+        times->clear();
+    if (cross.size() < iface.size())
+        return all;
+
+    int n = iface.size() - 1;
+    for (unsigned m = 0; m < cross[n].size(); m++)
+    {
+        // segments from B back to A
+        vector<const crossing*> chain;
+        int j = m;
+        for (int i = n; i >= 0; i--)
+        {
+            chain.push_back(&cross[i][j]);
+            j = cross[i][j].parent;
+        }
+
+        FFS_path_t p;
+        vector<double> ts;
+        double t0 = 0.;
+        for (int i = chain.size() - 1; i >= 0; i--)
+        {
+            const crossing& c = *chain[i];
+            // the first state of a segment is the last of the previous one
+            unsigned first = (i == (int) chain.size() - 1) ? 0 : 1;
+            for (unsigned s = first; s < c.path.size(); s++)
+            {
+                p.push_back(c.path[s]);
+                ts.push_back(t0 + c.ts[s]);
+            }
+            if (!c.ts.empty())
+                t0 += c.ts.back();
+        }
+        all.push_back(p);
+        if (times != NULL)
+            times->push_back(ts);
+    }
+    return all;
+}
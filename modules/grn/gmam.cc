@@ -0,0 +1,260 @@
+/******************************************************************************
+ *
+ *  gmam.cc
+ *
+ *  Implementation of the geometric minimum action method for the PONI
+ *  network.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define GMAM_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+#include "grn/gmam.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+GMAM::GMAM (const PONI& cell, const PONI_x_t& xA, const PONI_x_t& xB, int nodes)
+    : grn(cell)
+{
+    if (nodes < 3)
+    {
+        cout << "error: GMAM: at least three nodes are needed\n";
+        exit(EXIT_FAILURE);
+    }
+
+    delta = grn.getParameter("delta");
+    tau = .01;
+    maxIter = 100000;
+    tol = 1.e-6;
+    res = NAN;
+
+    phi.resize(nodes);
+    for (int i = 0; i < nodes; i++)
+        phi[i] = xA + (xB - xA)*i/(nodes - 1.);
+    accumulate();
+}
+
+
+void GMAM::setPath (const GMAM_path_t& path)
+{
+    if (path.size() < 2)
+    {
+        cout << "error: GMAM: the initial path needs at least two points\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // endpoints are kept
+    PONI_x_t xA = phi.front(), xB = phi.back();
+    int n = phi.size();
+    phi = path;
+    phi.front() = xA;
+    phi.back() = xB;
+    reparametrize(n);
+    accumulate();
+}
+
+
+//
+//  drift, diagonal of the diffusion and Jacobian of the drift at x
+//
+void GMAM::local (const PONI_x_t& x, PONI_x_t& b, PONI_x_t& a, PONI_J_t& J)
+{
+    grn.setState(x);
+    b = grn.getDrift();
+    a = grn.getProdR() + delta * x;
+    J = grn.getJacobian();
+}
+
+
+//
+//  redistribute n nodes at equal (euclidean) arclength along the path, by
+//  linear interpolation
+//
+void GMAM::reparametrize (int n)
+{
+    vector<double> s(phi.size(), 0.);
+    for (unsigned i = 1; i < phi.size(); i++)
+        s[i] = s[i-1] + (phi[i] - phi[i-1]).norm();
+    if (s.back() == 0.)
+    {
+        phi.resize(n, phi.back());
+        return;
+    }
+
+    GMAM_path_t p(n);
+    p[0] = phi.front();
+    p[n-1] = phi.back();
+    unsigned j = 1;
+    for (int i = 1; i < n - 1; i++)
+    {
+        double si = s.back()*i/(n - 1.);
+        while (j < s.size() - 1 && s[j] < si)
+            j++;
+        double w = (s[j] > s[j-1]) ? (si - s[j-1])/(s[j] - s[j-1]) : 0.;
+        p[i] = (1. - w)*phi[j-1] + w*phi[j];
+    }
+    phi = p;
+}
+
+
+//
+//  action of each segment, at its midpoint
+//
+void GMAM::accumulate ()
+{
+    PONI_x_t b, a;
+    PONI_J_t J;
+
+    V.assign(phi.size(), 0.);
+    for (unsigned i = 1; i < phi.size(); i++)
+    {
+        PONI_x_t d = phi[i] - phi[i-1];
+        local(.5*(phi[i] + phi[i-1]), b, a, J);
+        double dd = d.cwiseAbs2().cwiseQuotient(a).sum();
+        double bb = b.cwiseAbs2().cwiseQuotient(a).sum();
+        double db = d.cwiseProduct(b).cwiseQuotient(a).sum();
+        V[i] = V[i-1] + max(0., sqrt(dd*bb) - db);
+    }
+}
+
+
+//
+//  For H(x,theta) = <b,theta> + theta a theta/2, the minimizer solves
+//
+//      lambda^2 phi'' - lambda H_thx phi' + H_thth H_x - lambda lambda' phi' = 0
+//
+//  with lambda = |b|_a/|phi'|_a, theta = a^-1 (lambda phi' - b), and
+//
+//      H_thx = J + diag(theta) M,   H_x = J^T theta + M^T theta^2 / 2,
+//      H_thth = a,   M = da/dx = J + 2 delta.
+//
+//  Each iteration is an implicit step in phi'' (tridiagonal, the same for
+//  the four components) and an explicit one in the other terms.
+//
+int GMAM::relax ()
+{
+    const int n = phi.size();
+    const double h = 1./(n - 1);
+
+    vector<double> lambda(n, 0.), c(n, 0.), cp(n, 0.);
+    GMAM_path_t rhs(n), dp(n), b(n), a(n);
+    vector<PONI_J_t, aligned_allocator<PONI_J_t>> J(n);
+
+    int it;
+    for (it = 0; it < maxIter; it++)
+    {
+        for (int i = 1; i < n - 1; i++)
+        {
+            local(phi[i], b[i], a[i], J[i]);
+            dp[i] = (phi[i+1] - phi[i-1])/(2.*h);
+            double pp = dp[i].cwiseAbs2().cwiseQuotient(a[i]).sum();
+            double bb = b[i].cwiseAbs2().cwiseQuotient(a[i]).sum();
+            lambda[i] = (pp > 0.) ? sqrt(bb/pp) : 0.;
+        }
+        lambda[0] = lambda[1];
+        lambda[n-1] = lambda[n-2];
+
+        for (int i = 1; i < n - 1; i++)
+        {
+            PONI_x_t theta = (lambda[i]*dp[i] - b[i]).cwiseQuotient(a[i]);
+            PONI_J_t M = J[i] + 2.*delta*PONI_J_t::Identity();
+            PONI_J_t Hthx = J[i] + theta.asDiagonal()*M;
+            PONI_x_t Hx = J[i].transpose()*theta + .5*M.transpose()*theta.cwiseAbs2();
+            double dl = (lambda[i+1] - lambda[i-1])/(2.*h);
+
+            rhs[i] = phi[i] + tau*(- lambda[i]*Hthx*dp[i] + a[i].cwiseProduct(Hx)
+                                   - lambda[i]*dl*dp[i]);
+            c[i] = tau*lambda[i]*lambda[i]/(h*h);
+        }
+
+        // tridiagonal solve (Thomas), endpoints fixed
+        GMAM_path_t p = phi;
+        rhs[1] += c[1]*phi[0];
+        rhs[n-2] += c[n-2]*phi[n-1];
+        cp[1] = - c[1]/(1. + 2.*c[1]);
+        rhs[1] /= 1. + 2.*c[1];
+        for (int i = 2; i < n - 1; i++)
+        {
+            double m = 1. + 2.*c[i] + c[i]*cp[i-1];
+            cp[i] = - c[i]/m;
+            rhs[i] = (rhs[i] + c[i]*rhs[i-1])/m;
+        }
+        p[n-2] = rhs[n-2];
+        for (int i = n - 3; i >= 1; i--)
+            p[i] = rhs[i] - cp[i]*p[i+1];
+
+        // the state stays positive
+        for (int i = 1; i < n - 1; i++)
+            p[i] = p[i].cwiseMax(0.);
+
+        std::swap(phi, p);
+        reparametrize(n);
+
+        res = 0.;
+        for (int i = 1; i < n - 1; i++)
+            res = max(res, (phi[i] - p[i]).cwiseAbs().maxCoeff()/tau);
+        if (!std::isfinite(res))
+        {
+            cout << "error: GMAM: the relaxation diverged (decrease tau)\n";
+            exit(EXIT_FAILURE);
+        }
+        if (res < tol)
+            break;
+    }
+
+    accumulate();
+    return it;
+}
+
+
+PONI_x_t GMAM::saddle ()
+{
+    // interior node where the drift is the smallest (relative to the noise)
+    const int n = phi.size();
+    vector<double> bn(n);
+    for (int i = 0; i < n; i++)
+    {
+        PONI_x_t b, a;
+        PONI_J_t J;
+        local(phi[i], b, a, J);
+        bn[i] = b.cwiseAbs2().cwiseQuotient(a).sum();
+    }
+    int k = -1;
+    for (int i = 1; i < n - 1; i++)
+        if (bn[i] <= bn[i-1] && bn[i] <= bn[i+1] && (k < 0 || bn[i] < bn[k]))
+            k = i;
+    if (k < 0)
+        k = n/2;
+
+    PONI_x_t x = phi[k], b, a;
+    PONI_J_t J;
+    for (int it = 0; it < 50; it++)
+    {
+        local(x, b, a, J);
+        PONI_x_t dx = J.fullPivLu().solve(b);
+
+        // damped, so that the drift decreases and the state stays positive
+        double s = 1., b0 = b.norm();
+        for (int k = 0; k < 30; k++, s *= .5)
+        {
+            PONI_x_t y = x - s*dx;
+            grn.setState(y);
+            if (y.minCoeff() >= 0. && grn.getDrift().norm() < b0)
+                break;
+        }
+        x -= s*dx;
+        if (s*dx.norm() < 1.e-12)
+            break;
+    }
+    return x;
+}
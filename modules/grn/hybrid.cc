@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ *  hybrid.cc
+ *
+ *  Implementation of the PONIhybrid class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define HYBRID_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include "random.h"
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/hybrid.h"
+
+using namespace std;
+
+
+PONIhybrid::PONIhybrid (const PONI& cell)
+    : c(cell)
+{
+    threshold = 20.;
+    hysteresis = 2.;
+    events = 0;
+    discSteps = 0;
+    contSteps = 0;
+    setState(cell.getState());
+}
+
+
+// all the genes start in the continuous regime
+void PONIhybrid::setState (const PONI_x_t& x)
+{
+    c.setState(x);
+    for (int k = 0; k < 4; k++)
+    {
+        disc[k] = false;
+        cnt[k] = 0;
+    }
+}
+
+
+void PONIhybrid::classify ()
+{
+    const double Omega = c.Omega;
+    for (int k = 0; k < 4; k++)
+    {
+        double n = Omega * c.x(k);
+        if (disc[k] && n > hysteresis * threshold)
+            disc[k] = false;
+        else if (!disc[k] && n < threshold)
+        {
+            double u;
+            ranlxd(&u, 1);
+            cnt[k] = (long) floor(n);
+            if (u < n - cnt[k])
+                cnt[k]++;
+            c.x(k) = cnt[k] / Omega;
+            disc[k] = true;
+        }
+    }
+}
+
+
+//
+//  step dt: Euler-Maruyama step of the continuous genes, then the SSA of
+//  the discrete ones (their propensities are updated after each reaction,
+//  the continuous genes are held at the initial state)
+//
+void PONIhybrid::evolve (double dt)
+{
+    const double Omega = c.Omega, delta = c.delta;
+
+    classify();
+
+    int nd = 0;
+    for (int k = 0; k < 4; k++)
+        nd += disc[k];
+    discSteps += nd;
+    contSteps += 4 - nd;
+
+    c.setProdR();
+    const PONI_x_t x0 = c.x, r0 = c.prodR;
+    PONI_x_t y = x0;
+
+    STATS_ADD(steps, 1);
+    if (nd < 4)
+    {
+        const double sq = sqrt(dt/Omega);
+        double g[4];
+        bool neg;
+        STATS_ADD(redraws, -1);     // the first draw is not a redraw
+        do {
+            STATS_ADD(redraws, 1);
+            gauss_dble(g, 4);
+            neg = false;
+            for (int k = 0; k < 4; k++)
+                if (!disc[k])
+                {
+                    y(k) = x0(k) + (r0(k) - delta * x0(k)) * dt
+                         + sq * (sqrt(r0(k) + delta * x0(k)) * g[k]);
+                    neg = neg || (y(k) < 0.);
+                }
+        } while (neg);
+    }
+
+    if (nd > 0)
+    {
+        PONI_x_t r = r0;
+        double t = 0.;
+        for (;;)
+        {
+            double a[8], a0 = 0.;
+            for (int k = 0; k < 4; k++)
+            {
+                a[2*k] = disc[k] ? Omega * r(k) : 0.;
+                a[2*k+1] = disc[k] ? delta * cnt[k] : 0.;
+                a0 += a[2*k] + a[2*k+1];
+            }
+            if (!(a0 > 0.))
+                break;
+
+            double u[2];
+            ranlxd(u, 2);
+            t -= log(1. - u[0])/a0;
+            if (t >= dt)
+                break;
+
+            double s = u[1] * a0;
+            int j = 0;
+            while (j < 7 && (s -= a[j]) >= 0.)
+                j++;
+            while (a[j] == 0.)      // rounding at the end of the sum
+                j--;
+            int k = j/2;
+            cnt[k] += (j % 2 == 0) ? 1 : -1;
+            events++;
+
+            c.x(k) = cnt[k] / Omega;
+            c.setProdR();
+            r = c.prodR;
+        }
+        for (int k = 0; k < 4; k++)
+            if (disc[k])
+                y(k) = cnt[k] / Omega;
+    }
+
+    c.x = y;
+}
+
+
+void PONIhybrid::advance (double T, double dt)
+{
+    long steps = lround(T/dt);
+    for (long s = 0; s < steps; s++)
+        evolve(dt);
+}
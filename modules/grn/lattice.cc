@@ -0,0 +1,560 @@
+/******************************************************************************
+ *
+ *  lattice.cc
+ *
+ *  Implementation of the PONIlattice class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define LATTICE_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "random.h"
+#include "stats.h"
+#include "grn/poni.h"
+#include "grn/lattice.h"
+
+using namespace std;
+
+
+// same as Hill (grnfunc.cc), inlined in the loops over the cells
+static inline double hill (double z)
+{
+    return z/(1.+z);
+}
+
+
+//
+//  threads wait at the barrier until all of them have arrived (the steps
+//  are short, so they spin)
+//
+class Barrier {
+
+    const int count;
+    atomic<int> arrived;
+    atomic<long> generation;
+
+public:
+
+    Barrier (int c) : count(c), arrived(0), generation(0) {}
+
+    void wait ()
+    {
+        long gen = generation.load();
+        if (arrived.fetch_add(1) + 1 == count)
+        {
+            arrived.store(0);
+            generation.fetch_add(1);
+        }
+        else
+            while (generation.load() == gen)
+                this_thread::yield();
+    }
+};
+
+
+PONIlattice::PONIlattice (const PONI& cell, int width, int height)
+    : par(cell), nx(width), ny(height), n(width*height), cur(0)
+{
+    if (nx < 1 || ny < 1)
+    {
+        cout << "error: PONIlattice: the lattice needs at least one cell\n";
+        exit(EXIT_FAILURE);
+    }
+
+    buf[0].resize(4*n);
+    buf[1].resize(4*n);
+    for (int i = 0; i < n; i++)
+        setState(i, cell.getState());
+
+    h.resize(2*n);
+    kO.resize(n);
+    kN.resize(n);
+    gc.resize(4*n);
+    sc.resize(n);
+    setEffector(cell.getEffector());
+
+    // mean of the nearest neighbours
+    if (ny == 1)
+        setStencil({-1, 1}, {0, 0}, {.5, .5});
+    else
+        setStencil({-1, 1, 0, 0}, {0, 0, -1, 1}, {.25, .25, .25, .25});
+
+    tiles = 16;
+    threads = 1;
+    seed = 1;
+}
+
+
+void PONIlattice::setState (int i, const PONI_x_t& xi)
+{
+    for (int k = 0; k < 4; k++)
+        buf[cur][k*n + i] = xi(k);
+}
+
+PONI_x_t PONIlattice::getState (int i) const
+{
+    const double* x = buf[cur].data();
+    PONI_x_t xi;
+    xi << x[i], x[n + i], x[2*n + i], x[3*n + i];
+    return xi;
+}
+
+
+void PONIlattice::setEffector (const PONI_h_t& eff)
+{
+    for (int i = 0; i < n; i++)
+    {
+        h[i] = eff(0);
+        h[n + i] = eff(1);
+    }
+    makePlan();
+}
+
+void PONIlattice::setEffectors (const double* eff)
+{
+    h.assign(eff, eff + 2*n);
+    makePlan();
+}
+
+
+//
+//  same operations as PONI::makePlan, for each cell
+//
+void PONIlattice::makePlan ()
+{
+    const PONI& p = par;
+    for (int i = 0; i < n; i++)
+    {
+        double g;
+
+        g = 1. + p.f_A * p.K_Gli_Oli * h[i];
+        g /= 1. + p.K_Gli_Oli * (h[i] + h[n + i]);
+        kO[i] = p.K_Pol_Oli * p.C_Pol * g;
+
+        g = 1. + p.f_A * p.K_Gli_Nkx * h[i];
+        g /= 1. + p.K_Gli_Nkx * (h[i] + h[n + i]);
+        kN[i] = p.K_Pol_Nkx * p.C_Pol * g;
+    }
+}
+
+
+/*
+ *     ###   #   #  ####    #      ###   #   #   ###
+ *    #   #  #   #  #   #   #       #    ##  #  #
+ *    #      #   #  ####    #       #    # # #  #  ##
+ *    #   #  #   #  #       #       #    #  ##  #   #
+ *     ###    ###   #       #####  ###   #   #   ###
+ */
+
+void PONIlattice::setStencil (const vector<int>& dx, const vector<int>& dy,
+                              const vector<double>& w)
+{
+    if (dx.size() != dy.size() || dx.size() != w.size() || dx.empty())
+    {
+        cout << "error: PONIlattice: offsets and weights of the stencil do not match\n";
+        exit(EXIT_FAILURE);
+    }
+    sx = dx;
+    sy = dy;
+    sw = w;
+    makeNeighbours();
+}
+
+
+//
+//  neighbours of each cell, clamped to the lattice (no flux at the edges)
+//
+void PONIlattice::makeNeighbours ()
+{
+    const int m = sw.size();
+    nb.resize(m*n);
+    for (int j = 0; j < m; j++)
+        for (int iy = 0; iy < ny; iy++)
+            for (int ix = 0; ix < nx; ix++)
+            {
+                int jx = min(max(ix + sx[j], 0), nx - 1);
+                int jy = min(max(iy + sy[j], 0), ny - 1);
+                nb[j*n + ix + nx*iy] = jx + nx*jy;
+            }
+}
+
+
+void PONIlattice::addCoupling (const string& target, const string& source,
+                               double K, double f)
+{
+    const NET_dict& genes = par.dict;
+    auto t = genes.find(target), s = genes.find(source);
+    if (t == genes.end() || s == genes.end())
+    {
+        cout << "error: PONIlattice: invalid gene name (Pax, Oli, Nkx, Irx)\n";
+        exit(EXIT_FAILURE);
+    }
+    if (!(K >= 0.) || !(f >= 0.))
+    {
+        cout << "error: PONIlattice: the coupling constants must be >= 0\n";
+        exit(EXIT_FAILURE);
+    }
+    couplings.push_back({t->second, s->second, K, f});
+}
+
+
+/*
+ *    #####  #   #   ###   #       #   #  #####
+ *    #      #   #  #   #  #       #   #  #
+ *    ####   #   #  #   #  #       #   #  ####
+ *    #       # #   #   #  #        # #   #
+ *    #####    #     ###   #####     #    #####
+ */
+
+//
+//  step of the cells a...b-1 (tile t) from the states x to y: first the
+//  coupling factors (loops over the cells with the tabulated neighbours),
+//  then the Euler step of PONIbatch::evolve with the factors in the
+//  production
+//
+void PONIlattice::sweep (int t, int a, int b, const double* x, double* y,
+                         double dt, bool stoch)
+{
+    const PONI& p = par;
+    const double kPax = p.plan.kPax, kIrx = p.plan.kIrx;
+    const double sq = sqrt(dt/p.Omega);
+    const int m = sw.size();
+
+    double* G = gc.data();
+    double* S = sc.data();
+    for (int k = 0; k < 4; k++)
+        fill(G + k*n + a, G + k*n + b, 1.);
+    for (const coupling& c : couplings)
+    {
+        const double* xs = x + c.source*n;
+        double* Gt = G + c.target*n;
+        fill(S + a, S + b, 0.);
+        for (int j = 0; j < m; j++)
+        {
+            const int* nj = nb.data() + j*n;
+            const double w = sw[j];
+            for (int i = a; i < b; i++)
+                S[i] += w * xs[nj[i]];
+        }
+        const double fK = c.f * c.K, K = c.K;
+        for (int i = a; i < b; i++)
+            Gt[i] *= (1. + fK * S[i])/(1. + K * S[i]);
+    }
+
+    const double* x0 = x;
+    const double* x1 = x + n;
+    const double* x2 = x + 2*n;
+    const double* x3 = x + 3*n;
+    const double* G0 = G;
+    const double* G1 = G + n;
+    const double* G2 = G + 2*n;
+    const double* G3 = G + 3*n;
+    const double* kOli = kO.data();
+    const double* kNkx = kN.data();
+
+    // whole rows of the streams of the tile, then four rows of spares
+    const int ns = LATTICE_STREAMS;
+    const int rows = (4*(b - a) + ns - 1)/ns;
+    double* g = NULL;
+    double* gs = NULL;
+    int is = 4*ns;      // next spare number
+    if (stoch)
+    {
+        gt[t].resize((rows + 4)*ns);
+        g = gt[t].data();
+        gs = g + rows*ns;
+        gauss_dblev(g, rows);
+    }
+
+    STATS_ADD(steps, b - a);
+    STATS_ADD(prodR, b - a);
+    for (int i = a; i < b; i++)
+    {
+        double a1, a2, a3, r[4];
+
+        // Pax
+        a1 = 1./(1. + p.K_Oli_Pax * x1[i]);
+        a1 *= a1;
+        a2 = 1./(1. + p.K_Nkx_Pax * x2[i]);
+        a2 *= a2;
+        r[0] = p.alpha_Pax * hill(kPax * G0[i] * a1 * a2);
+
+        // Olig
+        a1 = 1./(1. + p.K_Nkx_Oli * x2[i]);
+        a1 *= a1;
+        a2 = 1./(1. + p.K_Irx_Oli * x3[i]);
+        a2 *= a2;
+        r[1] = p.alpha_Oli * hill(kOli[i] * G1[i] * a1 * a2);
+
+        // Nkx
+        a1 = 1./(1. + p.K_Pax_Nkx * x0[i]);
+        a1 *= a1;
+        a2 = 1./(1. + p.K_Oli_Nkx * x1[i]);
+        a2 *= a2;
+        a3 = 1./(1. + p.K_Irx_Nkx * x3[i]);
+        a3 *= a3;
+        r[2] = p.alpha_Nkx * hill(kNkx[i] * G2[i] * a1 * a2 * a3);
+
+        // Irx
+        a1 = 1./(1. + p.K_Oli_Irx * x1[i]);
+        a1 *= a1;
+        a2 = 1./(1. + p.K_Nkx_Irx * x2[i]);
+        a2 *= a2;
+        r[3] = p.alpha_Irx * hill(kIrx * G3[i] * a1 * a2);
+
+        double xi[4] = {x0[i], x1[i], x2[i], x3[i]}, xpp[4];
+        for (int k = 0; k < 4; k++)
+            xpp[k] = xi[k] + (r[k] - p.delta * xi[k]) * dt;
+
+        if (stoch)
+        {
+            double s[4], xp[4];
+            for (int k = 0; k < 4; k++)
+                s[k] = sqrt(r[k] + p.delta * xi[k]);
+
+            // the block of numbers for the first draw, redraws one by one
+            double* gi = g + 4*(i - a);
+            for (;;)
+            {
+                for (int k = 0; k < 4; k++)
+                    xp[k] = xpp[k] + sq * (s[k] * gi[k]);
+                if (xp[0] >= 0. && xp[1] >= 0. && xp[2] >= 0. && xp[3] >= 0.)
+                    break;
+                STATS_ADD(redraws, 1);
+                if (is == 4*ns)
+                {
+                    gauss_dblev(gs, 4);
+                    is = 0;
+                }
+                for (int k = 0; k < 4; k++)
+                    gi[k] = gs[is + k];
+                is += 4;
+            }
+            for (int k = 0; k < 4; k++)
+                xpp[k] = xp[k];
+        }
+
+        for (int k = 0; k < 4; k++)
+            y[k*n + i] = xpp[k];
+    }
+}
+
+
+//
+//  steps of the lattice: thread r updates the tiles r, r + nt, ... and
+//  waits for the others at the end of each step. Stochastic steps run on
+//  new threads, which load the generators of their tiles
+//
+void PONIlattice::run (long steps, double dt, bool stoch)
+{
+    if (steps <= 0)
+        return;
+
+    const int nt = max(1, min(tiles, n));
+    const int nth = max(1, min(threads, nt));
+    if (stoch)
+        gt.resize(nt);
+
+    auto worker = [&](int r, Barrier& bar) {
+        for (long k = 0; k < steps; k++)
+        {
+            const int from = (cur + k) & 1;
+            const double* x = buf[from].data();
+            double* y = buf[from ^ 1].data();
+            for (int t = r; t < nt; t += nth)
+            {
+                int a = (long) t*n/nt, b = (long) (t + 1)*n/nt;
+                if (stoch)
+                    rlxdv_reset(rng[t].data());
+                sweep(t, a, b, x, y, dt, stoch);
+                if (stoch)
+                    rlxdv_get(rng[t].data());
+            }
+            bar.wait();
+        }
+    };
+
+    if (stoch && (int) rng.size() != nt)
+    {
+        rng.assign(nt, vector<int>());
+        thread init([&]() {
+            for (int t = 0; t < nt; t++)
+            {
+                rlxdv_init(LATTICE_STREAMS, 1, seed + LATTICE_STREAMS*t);
+                rng[t].resize(rlxdv_size());
+                rlxdv_get(rng[t].data());
+            }
+        });
+        init.join();
+    }
+
+    Barrier bar(nth);
+    if (!stoch && nth == 1)
+        worker(0, bar);
+    else
+    {
+        vector<thread> pool;
+        for (int r = 0; r < nth; r++)
+            pool.push_back(thread(worker, r, ref(bar)));
+        for (auto& t : pool)
+            t.join();
+    }
+    cur = (cur + steps) & 1;
+}
+
+
+void PONIlattice::evolve (double dt, bool stoch)
+{
+    run(1, dt, stoch);
+}
+
+
+void PONIlattice::advance (double T, double dt, bool stoch)
+{
+    run(lround(T/dt), dt, stoch);
+}
+
+
+/*
+ *     ####   ###   #   #  #####
+ *    #      #   #  #   #  #
+ *     ###   #####  #   #  ####
+ *        #  #   #   # #   #
+ *    ####   #   #    #    #####
+ */
+
+//  Write the lattice in binary form: size, parameters (PONI::write), state
+//  and effectors of the cells, stencil, couplings, tiles and the generators
+//  of the tiles
+void PONIlattice::write (ostream& os) const
+{
+    int m = sw.size(), nc = couplings.size(), nr = rng.size();
+
+    os.write((const char*) &nx, sizeof(int));
+    os.write((const char*) &ny, sizeof(int));
+    par.write(os);
+    os.write((const char*) buf[cur].data(), 4*n*sizeof(double));
+    os.write((const char*) h.data(), 2*n*sizeof(double));
+
+    os.write((const char*) &m, sizeof(int));
+    os.write((const char*) sx.data(), m*sizeof(int));
+    os.write((const char*) sy.data(), m*sizeof(int));
+    os.write((const char*) sw.data(), m*sizeof(double));
+
+    os.write((const char*) &nc, sizeof(int));
+    for (const auto& c : couplings)
+    {
+        os.write((const char*) &c.target, sizeof(int));
+        os.write((const char*) &c.source, sizeof(int));
+        os.write((const char*) &c.K, sizeof(double));
+        os.write((const char*) &c.f, sizeof(double));
+    }
+
+    os.write((const char*) &tiles, sizeof(int));
+    os.write((const char*) &seed, sizeof(int));
+    os.write((const char*) &nr, sizeof(int));
+    for (const auto& r : rng)
+    {
+        int size = r.size();
+        os.write((const char*) &size, sizeof(int));
+        os.write((const char*) r.data(), size*sizeof(int));
+    }
+}
+
+
+//  Read what has been written by PONIlattice::write (threads is not changed)
+void PONIlattice::read (istream& is)
+{
+    int m = 0, nc = -1, nr = -1;
+
+    is.read((char*) &nx, sizeof(int));
+    is.read((char*) &ny, sizeof(int));
+    if (!is || nx < 1 || ny < 1)
+    {
+        cout << "error: read (PONIlattice): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    n = nx*ny;
+    par.read(is);
+
+    cur = 0;
+    buf[0].resize(4*n);
+    buf[1].resize(4*n);
+    h.resize(2*n);
+    kO.resize(n);
+    kN.resize(n);
+    gc.resize(4*n);
+    sc.resize(n);
+    is.read((char*) buf[0].data(), 4*n*sizeof(double));
+    is.read((char*) h.data(), 2*n*sizeof(double));
+
+    is.read((char*) &m, sizeof(int));
+    if (!is || m < 1 || m > 1024)
+    {
+        cout << "error: read (PONIlattice): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    sx.resize(m);
+    sy.resize(m);
+    sw.resize(m);
+    is.read((char*) sx.data(), m*sizeof(int));
+    is.read((char*) sy.data(), m*sizeof(int));
+    is.read((char*) sw.data(), m*sizeof(double));
+
+    is.read((char*) &nc, sizeof(int));
+    if (!is || nc < 0 || nc > 1024)
+    {
+        cout << "error: read (PONIlattice): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    couplings.resize(nc);
+    for (auto& c : couplings)
+    {
+        is.read((char*) &c.target, sizeof(int));
+        is.read((char*) &c.source, sizeof(int));
+        is.read((char*) &c.K, sizeof(double));
+        is.read((char*) &c.f, sizeof(double));
+        if (c.target < 0 || c.target > 3 || c.source < 0 || c.source > 3)
+            is.setstate(ios::failbit);
+    }
+
+    is.read((char*) &tiles, sizeof(int));
+    is.read((char*) &seed, sizeof(int));
+    is.read((char*) &nr, sizeof(int));
+    if (!is || nr < 0 || nr > n)
+    {
+        cout << "error: read (PONIlattice): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    rng.assign(nr, vector<int>());
+    for (auto& r : rng)
+    {
+        int size = 0;
+        is.read((char*) &size, sizeof(int));
+        if (!is || size < 1 || size > 6 + 100*LATTICE_STREAMS)
+        {
+            is.setstate(ios::failbit);
+            break;
+        }
+        r.resize(size);
+        is.read((char*) r.data(), size*sizeof(int));
+    }
+
+    if (!is)
+    {
+        cout << "error: read (PONIlattice): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+    makePlan();
+    makeNeighbours();
+}
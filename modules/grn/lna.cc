@@ -0,0 +1,118 @@
+/******************************************************************************
+ *
+ *  lna.cc
+ *
+ *  Implementation of the linear noise approximation and of the Gaussian
+ *  moment closure of the PONI network.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define LNA_CC
+
+#include <iostream>
+#include <cmath>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+#include "grn/lna.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+LNA::LNA (const PONI& cell, int cl)
+    : grn(cell)
+{
+    Sigma = PONI_J_t::Zero();
+    closure = cl;
+    Omega = grn.getParameter("Omega");
+}
+
+
+void LNA::setEffector (PONI_h_t eff)
+{
+    grn.setEffector(eff);
+}
+
+void LNA::setState (PONI_x_t mu)
+{
+    grn.setState(mu);
+}
+
+void LNA::setCovariance (const PONI_J_t& cov)
+{
+    Sigma = cov;
+}
+
+
+PONI_x_t LNA::getMean () const
+{
+    return grn.getState();
+}
+
+PONI_J_t LNA::getCovariance () const
+{
+    return Sigma;
+}
+
+PONI_x_t LNA::getStd () const
+{
+    return Sigma.diagonal().cwiseMax(0.).cwiseSqrt();
+}
+
+
+//
+//  c_i = 1/2 sum_jk d^2 F_i/dx_j dx_k Sigma_jk, with the second derivatives
+//  from central differences of the (analytic) Jacobian
+//
+PONI_x_t LNA::correction (const PONI_x_t& mu)
+{
+    const double eps = 1.e-5;
+    PONI_x_t c = PONI_x_t::Zero();
+
+    for (int k = 0; k < 4; k++)
+    {
+        PONI_x_t xp = mu, xm = mu;
+        xp(k) += eps;
+        xm(k) -= eps;
+        grn.setState(xp);
+        PONI_J_t Jp = grn.getJacobian();
+        grn.setState(xm);
+        PONI_J_t Jm = grn.getJacobian();
+
+        // column k of the Hessians: dJ(i,j)/dx(k)
+        c += .5 * ((Jp - Jm)/(2.*eps)) * Sigma.col(k);
+    }
+    grn.setState(mu);
+
+    return c;
+}
+
+
+void LNA::evolve (double dt)
+{
+    PONI_x_t mu = grn.getState();
+
+    PONI_x_t c = PONI_x_t::Zero();
+    if (closure == LNA_GAUSSIAN)
+        c = correction(mu);
+
+    // drift = prodR - delta x, so that prodR + delta x = 2 prodR - drift
+    PONI_x_t F = grn.getDrift();
+    PONI_x_t D = 2.*grn.getProdR() - F + c;
+    PONI_J_t J = grn.getJacobian();
+
+    PONI_J_t dSigma = J * Sigma + Sigma * J.transpose();
+    dSigma.diagonal() += D / Omega;
+
+    grn.setState(mu + dt * (F + c));
+    Sigma += dt * dSigma;
+}
+
+
+ostream& operator<< (ostream& os, const LNA& lna)
+{
+    os << lna.getMean().transpose() << "\t" << lna.getStd().transpose();
+    return os;
+}
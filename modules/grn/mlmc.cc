@@ -0,0 +1,243 @@
+/******************************************************************************
+ *
+ *  mlmc.cc
+ *
+ *  Implementation of the MLMC class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define MLMC_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/mlmc.h"
+
+using namespace std;
+
+
+//
+//  run tasks 0...n-1 on new threads (the generator of the calling thread
+//  is not touched)
+//
+static void parallel (int n, int threads, function<void(int)> task)
+{
+    atomic<int> next(0);
+    auto worker = [&]() {
+        for (int k = next++; k < n; k = next++)
+            task(k);
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < max(1, min(threads, n)); t++)
+        pool.push_back(thread(worker));
+    for (auto& t : pool)
+        t.join();
+}
+
+
+MLMC::MLMC (const PONIbatch& cells, MLMC_payoff_t P)
+    : start(cells), payoff(P)
+{
+    T = 300.;
+    dt0 = .1;
+    M = 2;
+    Lmin = 2;
+    Lmax = 10;
+    N0 = 100;
+    chunk = 10;
+    alpha = 1.;
+    threads = 1;
+    seed = 1;
+}
+
+
+// steps of a sample of level l (both paths)
+double MLMC::steps (int l) const
+{
+    double nf = T/dt0 * pow(M, l);
+    return (l == 0) ? nf : nf * (1. + 1./M);
+}
+
+
+//
+//  add[l] more samples to level l (rounded up to whole chunks)
+//
+void MLMC::sample (const vector<long>& add)
+{
+    struct task {
+        int l;
+        long c;
+        double sum, sum2, sumP, sumP2;
+    };
+    vector<task> tasks;
+    for (unsigned l = 0; l < add.size(); l++)
+    {
+        long nc = (add[l] + chunk - 1)/chunk;
+        for (long c = 0; c < nc; c++)
+            tasks.push_back({(int) l, lev[l].chunks + c, 0., 0., 0., 0.});
+        lev[l].chunks += nc;
+        lev[l].n += nc*chunk;
+    }
+
+    const int nw = 4*start.size();
+    parallel(tasks.size(), threads, [&](int k) {
+        task& tk = tasks[k];
+        const int l = tk.l;
+        rlxd_init(1, seed + 64*tk.c + l);
+
+        const double dtf = dt0/pow(M, l), dtc = M*dtf;
+        const long nsteps = lround(T/((l == 0) ? dtf : dtc));
+        vector<double> w(nw), wc(nw);
+
+        for (int s = 0; s < chunk; s++)
+        {
+            PONIbatch fine = start;
+            double Pf, Pc = 0.;
+            if (l == 0)
+            {
+                for (long j = 0; j < nsteps; j++)
+                {
+                    gauss_dble(w.data(), nw);
+                    fine.evolve(dtf, w.data());
+                }
+                Pf = payoff(fine);
+            }
+            else
+            {
+                PONIbatch coarse = start;
+                const double norm = 1./sqrt((double) M);
+                for (long j = 0; j < nsteps; j++)
+                {
+                    fill(wc.begin(), wc.end(), 0.);
+                    for (int m = 0; m < M; m++)
+                    {
+                        gauss_dble(w.data(), nw);
+                        fine.evolve(dtf, w.data());
+                        for (int i = 0; i < nw; i++)
+                            wc[i] += w[i];
+                    }
+                    for (int i = 0; i < nw; i++)
+                        wc[i] *= norm;
+                    coarse.evolve(dtc, wc.data());
+                }
+                Pf = payoff(fine);
+                Pc = payoff(coarse);
+            }
+
+            double Y = Pf - Pc;
+            tk.sum += Y;
+            tk.sum2 += Y*Y;
+            tk.sumP += Pf;
+            tk.sumP2 += Pf*Pf;
+        }
+    });
+
+    // sums in the order of the tasks, whatever the threads
+    for (const task& tk : tasks)
+    {
+        lev[tk.l].sum += tk.sum;
+        lev[tk.l].sum2 += tk.sum2;
+        lev[tk.l].sumP += tk.sumP;
+        lev[tk.l].sumP2 += tk.sumP2;
+    }
+}
+
+
+double MLMC::estimate (double eps)
+{
+    if (!(eps > 0.) || M < 2 || Lmin < 1 || Lmax < Lmin || Lmax > 63 || chunk < 1
+        || N0 < 1 || !(dt0 > 0.) || !(T > 0.))
+    {
+        cout << "error: MLMC: invalid tolerance or settings\n";
+        exit(EXIT_FAILURE);
+    }
+
+    lev.assign(Lmin + 1, {0, 0, 0., 0., 0., 0.});
+    vector<long> add(Lmin + 1, N0);
+
+    for (;;)
+    {
+        sample(add);
+
+        // optimal samples of each level (variance eps^2/2)
+        const int L = lev.size() - 1;
+        double s = 0.;
+        for (int l = 0; l <= L; l++)
+            s += sqrt(max(variance(l), 1.e-300) * steps(l));
+        bool more = false;
+        add.assign(L + 1, 0);
+        for (int l = 0; l <= L; l++)
+        {
+            double Nl = ceil(2./(eps*eps) * sqrt(max(variance(l), 1.e-300)/steps(l)) * s);
+            add[l] = max(0L, (long) Nl - lev[l].n);
+            more = more || (add[l] > .01*lev[l].n);
+        }
+        if (more)
+            continue;
+
+        // bias of the finest level (from the last two differences, for
+        // robustness: Y_0 is not a difference)
+        double ma = pow(M, alpha);
+        double bias = fabs(mean(L));
+        if (L > 1)
+            bias = max(bias, fabs(mean(L-1))/ma);
+        bias /= ma - 1.;
+        if (bias < eps/sqrt(2.) || L == Lmax)
+        {
+            if (bias >= eps/sqrt(2.))
+                cerr << "MLMC: the bias is above the tolerance at the largest level\n";
+            break;
+        }
+
+        lev.push_back({0, 0, 0., 0., 0., 0.});
+        add.assign(L + 2, 0);
+        add[L + 1] = N0;
+    }
+
+    double E = 0.;
+    for (int l = 0; l < (int) lev.size(); l++)
+        E += mean(l);
+    return E;
+}
+
+
+double MLMC::mean (int l) const
+{
+    return lev[l].sum/lev[l].n;
+}
+
+double MLMC::variance (int l) const
+{
+    double m = mean(l);
+    return max(0., lev[l].sum2/lev[l].n - m*m);
+}
+
+double MLMC::meanFine (int l) const
+{
+    return lev[l].sumP/lev[l].n;
+}
+
+double MLMC::varianceFine (int l) const
+{
+    double m = meanFine(l);
+    return max(0., lev[l].sumP2/lev[l].n - m*m);
+}
+
+double MLMC::cost () const
+{
+    double c = 0.;
+    for (int l = 0; l < (int) lev.size(); l++)
+        c += lev[l].n * steps(l);
+    return c;
+}
@@ -0,0 +1,692 @@
+/******************************************************************************
+ *
+ *  netgrn.cc
+ *
+ *  Implementation of the run-time thermodynamic GRN class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define NETGRN_CC
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <Eigen/Dense>
+#include "random.h"
+#include "stats.h"
+#include "grn/netgrn.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+/*
+ *    ####   #      ###   #   #
+ *    #   #  #     #   #  ##  #
+ *    ####   #     #####  # # #
+ *    #      #     #   #  #  ##
+ *    #      ####  #   #  #   #
+ */
+
+void NetPlan::prodR (const double* x, const double* h, double* out) const
+{
+    double hA = 0., hT = 0.;
+    for (int k = 0; k < M; k++)
+    {
+        hA += act[k] * h[k];
+        hT += h[k];
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        double z = base[i];
+
+        // activation by the effectors
+        if (Keff[i] != 0.)
+            z *= (1. + f_A * Keff[i] * hA)/(1. + Keff[i] * hT);
+
+        // repression terms
+        for (int t = start[i]; t < start[i+1]; t++)
+        {
+            double r = 1./(1. + K[t] * x[src[t]]);
+            double p = r;
+            for (int c = 1; c < coop[t]; c++)
+                p *= r;
+            z *= p;
+        }
+
+        out[i] = alpha[i] * z/(1. + z);
+    }
+}
+
+
+void NetPlan::prodR (int n, const double* const* x, const double* const* h,
+                     double* const* out) const
+{
+    for (int i = 0; i < N; i++)
+    {
+        double* z = out[i];
+
+        if (Keff[i] != 0.)
+        {
+            const double a = f_A * Keff[i];
+            for (int c = 0; c < n; c++)
+            {
+                double hA = 0., hT = 0.;
+                for (int k = 0; k < M; k++)
+                {
+                    hA += act[k] * h[k][c];
+                    hT += h[k][c];
+                }
+                z[c] = base[i] * ((1. + a * hA)/(1. + Keff[i] * hT));
+            }
+        }
+        else
+            for (int c = 0; c < n; c++)
+                z[c] = base[i];
+
+        // one sweep over the cells per term (vectorizable inner loops)
+        for (int t = start[i]; t < start[i+1]; t++)
+        {
+            const double* xs = x[src[t]];
+            const double Kt = K[t];
+            const int ct = coop[t];
+            for (int c = 0; c < n; c++)
+            {
+                double r = 1./(1. + Kt * xs[c]);
+                double p = r;
+                for (int k = 1; k < ct; k++)
+                    p *= r;
+                z[c] *= p;
+            }
+        }
+
+        for (int c = 0; c < n; c++)
+            z[c] = alpha[i] * z[c]/(1. + z[c]);
+    }
+}
+
+
+/*
+ *    ####    ###   ####    ###   #   #  #####  #####  #####  ####    ####
+ *    #   #  #   #  #   #  #   #  ## ##  #        #    #      #   #  #
+ *    ####   #####  ####   #####  # # #  ####     #    ####   ####    ###
+ *    #      #   #  #  #   #   #  #   #  #        #    #      #  #       #
+ *    #      #   #  #   #  #   #  #   #  #####    #    #####  #   #  ####
+ */
+
+static void specError (const char* filename, const string& line, const char* msg)
+{
+    cout << "error: NetGRN: " << msg << " in \"" << filename << "\":  "
+         << line << "\n";
+    exit(EXIT_FAILURE);
+}
+
+
+//
+//  Read the description of the network
+//
+void NetGRN::readNetwork (const char* filename)
+{
+    ifstream netf(filename);
+    if (!netf)
+    {
+        cout << "error: NetGRN: cannot open \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    binder = "Gli";
+    vector<string> targetNames, activNames;
+    vector<pair<string,double>> initial;
+    string line, key, name;
+
+    while (getline(netf, line))
+    {
+        line = line.substr(0, line.find('#'));
+        istringstream ls(line);
+        if (!(ls >> key))
+            continue;
+
+        if (key == "genes")
+            while (ls >> name)
+            {
+                genes[name] = geneNames.size();
+                geneNames.push_back(name);
+            }
+        else if (key == "effectors")
+            while (ls >> name)
+            {
+                effectors[name] = effNames.size();
+                effNames.push_back(name);
+            }
+        else if (key == "activators")
+            while (ls >> name)
+                activNames.push_back(name);
+        else if (key == "targets")
+            while (ls >> name)
+                targetNames.push_back(name);
+        else if (key == "binder")
+        {
+            if (!(ls >> binder))
+                specError(filename, line, "missing binder name");
+        }
+        else if (key == "repression")
+        {
+            string reg, tgt;
+            int c;
+            if (!(ls >> reg >> tgt >> c) || c < 1)
+                specError(filename, line, "bad repression entry");
+            if (genes.count(reg) == 0 || genes.count(tgt) == 0)
+                specError(filename, line, "unknown gene");
+            repSource.push_back(genes[reg]);
+            repTarget.push_back(genes[tgt]);
+            repCoop.push_back(c);
+        }
+        else if (key == "initial")
+        {
+            double val;
+            if (!(ls >> name >> val))
+                specError(filename, line, "bad initial condition");
+            initial.push_back(make_pair(name, val));
+        }
+        else
+        {
+            double val;
+            if (!(ls >> val))
+                specError(filename, line, "bad parameter entry");
+            pars[key] = val;
+        }
+    }
+    netf.close();
+
+    if (geneNames.empty())
+        specError(filename, "", "no genes");
+
+    int N = geneNames.size();
+    int M = effNames.size();
+
+    target.assign(N, false);
+    for (const auto& g : targetNames)
+    {
+        if (genes.count(g) == 0)
+            specError(filename, g, "unknown target gene");
+        target[genes[g]] = true;
+    }
+
+    activating.assign(M, false);
+    for (const auto& e : activNames)
+    {
+        if (effectors.count(e) == 0)
+            specError(filename, e, "unknown effector");
+        activating[effectors[e]] = true;
+    }
+
+    x0 = VectorXd::Zero(N);
+    for (const auto& i : initial)
+    {
+        if (genes.count(i.first) == 0)
+            specError(filename, i.first, "unknown gene");
+        x0(genes[i.first]) = i.second;
+    }
+
+    // parameters not in the description take the PONI defaults
+    const PAR_dict common = {
+        {"lambdaConc",1},
+        {"lambdaTime",1},
+        {"f_A", 10.},
+        {"C_Pol", .8},
+        {"delta", 2.},
+        {"Omega", 1000.},
+    };
+    for (const auto& p : common)
+        if (pars.count(p.first) == 0)
+            pars[p.first] = p.second;
+}
+
+
+double NetGRN::parameter (const string& key)
+{
+    auto it = pars.find(key);
+    if (it == pars.end())
+    {
+        cout << "error: NetGRN: no value for parameter \"" << key << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    return it->second;
+}
+
+
+//
+//  Assign the values in the unordered map to the evaluation plan
+//
+void NetGRN::assignParameters ()
+{
+    int N = geneNames.size();
+    int M = effNames.size();
+
+    double lambdaConc = parameter("lambdaConc");
+    double lambdaTime = parameter("lambdaTime");
+    double C_Pol = parameter("C_Pol") * lambdaConc;
+
+    plan.N = N;
+    plan.M = M;
+    plan.f_A   = parameter("f_A");
+    plan.delta = parameter("delta") / lambdaTime;
+    plan.Omega = parameter("Omega");
+
+    plan.base.resize(N);
+    plan.Keff.resize(N);
+    plan.alpha.resize(N);
+    for (int i = 0; i < N; i++)
+    {
+        plan.base[i] = parameter("K_Pol_" + geneNames[i]) / lambdaConc * C_Pol;
+        plan.alpha[i] = parameter("alpha_" + geneNames[i]) * lambdaConc / lambdaTime;
+        plan.Keff[i] = 0.;
+        if (target[i])
+            plan.Keff[i] = parameter("K_" + binder + "_" + geneNames[i]) / lambdaConc;
+    }
+
+    plan.act.resize(M);
+    for (int k = 0; k < M; k++)
+        plan.act[k] = activating[k] ? 1. : 0.;
+
+    // repression terms, sorted by target
+    plan.start.assign(N+1, 0);
+    plan.src.clear();
+    plan.coop.clear();
+    plan.K.clear();
+    for (int i = 0; i < N; i++)
+    {
+        plan.start[i] = plan.src.size();
+        for (unsigned t = 0; t < repTarget.size(); t++)
+            if (repTarget[t] == i)
+            {
+                int j = repSource[t];
+                plan.src.push_back(j);
+                plan.coop.push_back(repCoop[t]);
+                plan.K.push_back(parameter("K_" + geneNames[j] + "_" + geneNames[i])
+                                 / lambdaConc);
+            }
+    }
+    plan.start[N] = plan.src.size();
+}
+
+
+//  Set one parameter through its key (string)
+void NetGRN::setParameters (string key, double val)
+{
+    auto it = pars.find(key);
+    if(it != pars.end())
+        it->second = val;
+    else
+    {
+        cout << "error: setParameters (NetGRN): invalid parameter name \""
+             << key << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    assignParameters();
+}
+
+
+//  Set a number of parameters contained into a file in "key  value" form
+void NetGRN::setParameters (const char* filename)
+{
+    ifstream parf(filename);
+    string key;
+    double val;
+    while (parf >> key >> val)
+    {
+        auto it = pars.find(key);
+        if(it != pars.end())
+            it->second = val;
+        else
+        {
+            cout << "error: setParameters: invalid parameter name in \""
+                 << filename << "\":  " << key << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    parf.close();
+    assignParameters();
+}
+
+
+void NetGRN::testParameters (const char* filename)
+{
+    ofstream os;
+    os.open(filename, ios::out);
+    this->testParameters(os);
+    os.close();
+}
+
+
+void NetGRN::testParameters (ostream& os)
+{
+    os << "# network parameters\n";
+    for( const auto& n : pars )
+    {
+        os << n.first << "\t\t" << n.second << "\n";
+    }
+    os << "\n";
+}
+
+
+/*
+ *     ###   ###   #   #   ###  #####  ####
+ *    #     #   #  ##  #  #       #    #   #
+ *    #     #   #  # # #   ##     #    ####
+ *    #     #   #  #  ##     #    #    #  #    ##
+ *     ###   ###   #   #  ###     #    #   #   ##
+ */
+
+NetGRN::NetGRN (const char* filename)
+{
+    readNetwork(filename);
+    assignParameters();
+
+    int N = geneNames.size();
+    x = x0;
+    h = VectorXd::Zero(effNames.size());
+    prodR = VectorXd::Zero(N);
+    drift = VectorXd::Zero(N);
+    noise = VectorXd::Zero(N);
+    xp = VectorXd::Zero(N);
+    xpp = VectorXd::Zero(N);
+}
+
+
+/*
+ *    #   #  ####  #####  #   #   ###   ####    ###
+ *    ## ##  #       #    #   #  #   #  #   #  #
+ *    # # #  ###     #    #####  #   #  #   #   ##
+ *    #   #  #       #    #   #  #   #  #   #     #
+ *    #   #  ####    #    #   #   ###   ####   ###
+ */
+
+int NetGRN::size () const
+{
+    return geneNames.size();
+}
+
+int NetGRN::effectorSize () const
+{
+    return effNames.size();
+}
+
+const NetPlan& NetGRN::getPlan () const
+{
+    return plan;
+}
+
+void NetGRN::setState (VectorXd vec)
+{
+    if (vec.size() != x.size())
+    {
+        cout << "error: NetGRN: setState: wrong size of the state\n";
+        exit(EXIT_FAILURE);
+    }
+    x = vec;
+}
+
+void NetGRN::setEffector (VectorXd eff)
+{
+    if (eff.size() != h.size())
+    {
+        cout << "error: NetGRN: setEffector: wrong number of effectors\n";
+        exit(EXIT_FAILURE);
+    }
+    h = eff;
+}
+
+ostream& operator<< (ostream& os, const NetGRN& g)
+{
+    os << (g.x).transpose() << "\t" << (g.h).transpose();
+    return os;
+}
+
+VectorXd NetGRN::getInitialState () const
+{
+    return x0;
+}
+
+VectorXd NetGRN::getState () const
+{
+    return x;
+}
+
+VectorXd NetGRN::getEffector () const
+{
+    return h;
+}
+
+VectorXd NetGRN::getDrift ()
+{
+    setDrift();
+    return drift;
+}
+
+VectorXd NetGRN::getProdR ()
+{
+    setProdR();
+    return prodR;
+}
+
+void NetGRN::setProdR ()
+{
+    STATS_ADD(prodR,1);
+    plan.prodR(x.data(), h.data(), prodR.data());
+}
+
+void NetGRN::setDrift ()
+{
+    setProdR();
+    drift = prodR - plan.delta * x;
+}
+
+void NetGRN::setNoise ()
+{
+    gauss_dble(noise.data(),noise.size());
+    for (int i = 0; i < noise.size(); i++)
+        noise(i) *= sqrt(prodR(i) + plan.delta * x(i));
+}
+
+
+void NetGRN::evolve (double dt, bool stoch)
+{
+    STATS_ADD(steps,1);
+    setDrift();       // this also sets the necessary variables for noise
+    xpp = x + drift * dt;
+    xp = xpp;
+    if (stoch) {
+        STATS_ADD(redraws,-1);   // the first draw is not a redraw
+        do {
+            STATS_ADD(redraws,1);
+            setNoise();
+            xp = xpp + sqrt(dt/plan.Omega) * noise;
+        } while ( (xp.array() < 0.).any() );
+    }
+    x = xp;
+}
+
+
+/*
+ *    ####    ###   #####   ###   #   #
+ *    #   #  #   #    #    #      #   #
+ *    ####   #####    #    #      #####
+ *    #   #  #   #    #    #      #   #
+ *    ####   #   #    #     ###   #   #
+ */
+
+NetBatch::NetBatch (const NetGRN& cell, int ncells)
+    : plan(cell.getPlan()), n(ncells)
+{
+    if (n < 1)
+    {
+        cout << "error: NetBatch: the batch must have at least one cell\n";
+        exit(EXIT_FAILURE);
+    }
+    x.resize(plan.N*n);
+    h.resize(plan.M*n);
+
+    VectorXd x0 = cell.getState(), h0 = cell.getEffector();
+    for (int c = 0; c < n; c++)
+    {
+        setState(c, x0);
+        setEffector(c, h0);
+    }
+
+    tiles = 16;
+    threads = 1;
+    seed = 1;
+}
+
+
+void NetBatch::setState (int c, const VectorXd& xc)
+{
+    for (int i = 0; i < plan.N; i++)
+        x[i*n + c] = xc(i);
+}
+
+VectorXd NetBatch::getState (int c) const
+{
+    VectorXd xc(plan.N);
+    for (int i = 0; i < plan.N; i++)
+        xc(i) = x[i*n + c];
+    return xc;
+}
+
+void NetBatch::setEffector (int c, const VectorXd& eff)
+{
+    if (eff.size() != plan.M)
+    {
+        cout << "error: NetBatch: setEffector: wrong number of effectors\n";
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < plan.M; k++)
+        h[k*n + c] = eff(k);
+}
+
+
+//
+//  steps of the cells a, ..., b-1 (the same arithmetic as NetGRN::evolve)
+//
+void NetBatch::sweep (int a, int b, long steps, double dt, bool stoch)
+{
+    const int N = plan.N, M = plan.M, m = b - a;
+    const double sq = sqrt(dt/plan.Omega);
+
+    vector<const double*> xc(N), hc(M);
+    vector<double*> pc(N);
+    vector<double> p(N*m), g(stoch ? N*m : 0), xpp(N), s(N);
+    for (int i = 0; i < N; i++)
+    {
+        xc[i] = x.data() + i*n + a;
+        pc[i] = p.data() + i*m;
+    }
+    for (int k = 0; k < M; k++)
+        hc[k] = h.data() + k*n + a;
+
+    for (long t = 0; t < steps; t++)
+    {
+        STATS_ADD(steps, m);
+        STATS_ADD(prodR, m);
+        plan.prodR(m, xc.data(), hc.data(), pc.data());
+
+        if (!stoch)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                double* xi = x.data() + i*n + a;
+                const double* pi = pc[i];
+                for (int c = 0; c < m; c++)
+                    xi[c] = xi[c] + (pi[c] - plan.delta * xi[c]) * dt;
+            }
+            continue;
+        }
+
+        // the block of numbers for the first draw, redraws cell by cell
+        gauss_dble(g.data(), N*m);
+        for (int c = 0; c < m; c++)
+        {
+            for (int i = 0; i < N; i++)
+            {
+                double xi = x[i*n + a + c], pi = p[i*m + c];
+                xpp[i] = xi + (pi - plan.delta * xi) * dt;
+                s[i] = sqrt(pi + plan.delta * xi);
+            }
+
+            double* gc = g.data() + N*c;
+            for (;;)
+            {
+                bool neg = false;
+                for (int i = 0; i < N; i++)
+                    neg = neg || (xpp[i] + sq * (s[i] * gc[i]) < 0.);
+                if (!neg)
+                    break;
+                STATS_ADD(redraws, 1);
+                gauss_dble(gc, N);
+            }
+            for (int i = 0; i < N; i++)
+                x[i*n + a + c] = xpp[i] + sq * (s[i] * gc[i]);
+        }
+    }
+}
+
+
+void NetBatch::advance (double T, double dt, bool stoch)
+{
+    const long steps = lround(T/dt);
+    if (steps <= 0)
+        return;
+
+    const int nt = max(1, min(tiles, n));
+    const int nth = max(1, min(threads, nt));
+
+    if (stoch && (int) rng.size() != nt)
+    {
+        rng.assign(nt, vector<int>(rlxd_size()));
+        thread init([&]() {
+            for (int t = 0; t < nt; t++)
+            {
+                rlxd_init(1, seed + t);
+                rlxd_get(rng[t].data());
+            }
+        });
+        init.join();
+    }
+
+    // thread r takes the next tile, and evolves it for all the steps
+    atomic<int> next(0);
+    auto worker = [&]() {
+        for (int t = next++; t < nt; t = next++)
+        {
+            int a = (long) t*n/nt, b = (long) (t + 1)*n/nt;
+            if (stoch)
+                rlxd_reset(rng[t].data());
+            sweep(a, b, steps, dt, stoch);
+            if (stoch)
+                rlxd_get(rng[t].data());
+        }
+    };
+
+    // stochastic steps run on new threads, which load the generators
+    if (!stoch && nth == 1)
+        worker();
+    else
+    {
+        vector<thread> pool;
+        for (int r = 0; r < nth; r++)
+            pool.push_back(thread(worker));
+        for (auto& t : pool)
+            t.join();
+    }
+}
@@ -0,0 +1,130 @@
+/******************************************************************************
+ *
+ *  parareal.cc
+ *
+ *  Implementation of the Parareal class.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define PARAREAL_CC
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "grn/poni.h"
+#include "grn/parareal.h"
+
+using namespace std;
+
+
+typedef vector<PONI_x_t, aligned_allocator<PONI_x_t>> PARAREAL_x_t;
+
+
+//
+//  run tasks 0...n-1 on new threads
+//
+static void parallel (int n, int threads, function<void(int)> task)
+{
+    atomic<int> next(0);
+    auto worker = [&]() {
+        for (int k = next++; k < n; k = next++)
+            task(k);
+    };
+
+    vector<thread> pool;
+    for (int t = 0; t < max(1, min(threads, n)); t++)
+        pool.push_back(thread(worker));
+    for (auto& t : pool)
+        t.join();
+}
+
+
+Parareal::Parareal (const PONI& cell, long steps, double step)
+    : start(cell), nsteps(steps), dt(step), iters(0)
+{
+    slices = 8;
+    threads = 1;
+    dtCoarse = .25;
+    tol = 1.e-10;
+}
+
+
+long Parareal::first (int n) const
+{
+    return nsteps*n/slices;
+}
+
+
+// coarse propagation of slice n, with a whole number of steps
+PONI_x_t Parareal::coarse (int n, const PONI_x_t& x) const
+{
+    double T = (first(n + 1) - first(n))*dt;
+    long m = max(1L, lround(T/dtCoarse));
+    PONI c = start;
+    c.setState(x);
+    c.integrate(m, T/m, false);
+    return c.getState();
+}
+
+
+PONI_x_t Parareal::run ()
+{
+    if (slices < 1 || threads < 1 || !(dt > 0.) || !(dtCoarse > 0.) || nsteps < 0)
+    {
+        cout << "error: Parareal: invalid slices, threads or steps\n";
+        exit(EXIT_FAILURE);
+    }
+    slices = max(1L, min((long) slices, nsteps));
+
+    // sequential coarse run
+    PARAREAL_x_t U(slices + 1), G(slices), F(slices);
+    U[0] = start.getState();
+    for (int n = 0; n < slices; n++)
+    {
+        G[n] = coarse(n, U[n]);
+        U[n+1] = G[n];
+    }
+
+    for (iters = 0; iters < slices; )
+    {
+        const int k = iters;
+
+        // fine propagation of the slices which are not exact yet
+        parallel(slices - k, threads, [&](int j) {
+            const int n = k + j;
+            PONI c = start;
+            c.setState(U[n]);
+            c.integrate(first(n + 1) - first(n), dt, false);
+            F[n] = c.getState();
+        });
+        iters++;
+
+        // correction (the state after slice k is exact)
+        double change = 0.;
+        for (int n = k; n < slices; n++)
+        {
+            PONI_x_t u;
+            if (n == k)
+                u = F[n];
+            else
+            {
+                PONI_x_t g = coarse(n, U[n]);
+                u = g + F[n] - G[n];
+                G[n] = g;
+            }
+            change = max(change, (u - U[n+1]).cwiseAbs().maxCoeff());
+            U[n+1] = u;
+        }
+        if (change < tol)
+            break;
+    }
+
+    return U[slices];
+}
@@ -18,6 +18,7 @@
 #include <vector>
 #include <Eigen/Dense>
 #include "random.h"
+#include "stats.h"
 #include "grn/poni.h"
 
 using namespace std;
@@ -98,6 +99,31 @@ void PONI::assignParameters()
     alpha_Irx   = pars["alpha_Irx"]  * lambdaConc / lambdaTime;
     delta       = pars["delta"]      / lambdaTime;
     Omega       = pars["Omega"];
+
+    makePlan();
+}
+
+
+//
+//  Fold the factors of the production rates that are constant while the
+//  parameters and the effectors are (in the order of the products in
+//  setProdR, so that the rates do not change)
+//
+void PONI::makePlan()
+{
+    double g;
+
+    plan.kPax = K_Pol_Pax * C_Pol;
+
+    g = 1. + f_A * K_Gli_Oli * h(0);
+    g /= 1. + K_Gli_Oli * ( h(0) + h(1) );
+    plan.kOli = K_Pol_Oli * C_Pol * g;
+
+    g = 1. + f_A * K_Gli_Nkx * h(0);
+    g /= 1. + K_Gli_Nkx * ( h(0) + h(1) );
+    plan.kNkx = K_Pol_Nkx * C_Pol * g;
+
+    plan.kIrx = K_Pol_Irx * C_Pol;
 }
 
 
@@ -146,6 +172,20 @@ void PONI::setParameters(const char* filename)
 }
 
 
+//  Value of a parameter (as in the file, before rescaling)
+double PONI::getParameter(string key) const
+{
+    auto it = pars.find(key);
+    if(it == pars.end())
+    {
+        cout << "error: getParameter (PONI): invalid parameter name \""
+             << key << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+    return it->second;
+}
+
+
 void PONI::testParameters(const char* filename)
 {
     ofstream os;
@@ -253,11 +293,13 @@ void PONI::setState(PONI_x_t vec)
 void PONI::setEffector(double eff1, double eff2)
 {
     h << eff1, eff2;
+    makePlan();
 }
 
 void PONI::setEffector(PONI_h_t eff)
 {
     h = eff;
+    makePlan();
 }
 
 
@@ -285,9 +327,9 @@ PONI_x_t PONI::getDrift ()
 
 void PONI::setProdR ()
 {
-    prodR << 0., 0., 0., 0.;
+    STATS_ADD(prodR,1);
 
-    double aux_1, aux_2, aux_3, aux_4;
+    double aux_1, aux_2, aux_3;
 
     //
     // Pax
@@ -300,49 +342,41 @@ void PONI::setProdR ()
     // Repression by Nkx
     aux_2 = 1./(1. + K_Nkx_Pax * x(2));
     aux_2 *= aux_2;
-    prodR(0) = alpha_Pax * Hill(K_Pol_Pax * C_Pol * aux_1 * aux_2);
+    prodR(0) = alpha_Pax * Hill(plan.kPax * aux_1 * aux_2);
 
 
     //
-    // Olig
+    // Olig (activation by Gli in the plan)
     //
 
-    // Activation by Gli
-    aux_1 = 1. + f_A * K_Gli_Oli * h(0);
-    aux_1 /= 1. + K_Gli_Oli * ( h(0) + h(1) );
-
     // Repression by Nkx
-    aux_2 = 1./(1. + K_Nkx_Oli * x(2));
-    aux_2 *= aux_2;
+    aux_1 = 1./(1. + K_Nkx_Oli * x(2));
+    aux_1 *= aux_1;
 
     // Repression by Irx
-    aux_3 = 1./(1. + K_Irx_Oli * x(3));
-    aux_3 *= aux_3;
+    aux_2 = 1./(1. + K_Irx_Oli * x(3));
+    aux_2 *= aux_2;
 
-    prodR(1) = alpha_Oli * Hill(K_Pol_Oli * C_Pol * aux_1 * aux_2 * aux_3);
+    prodR(1) = alpha_Oli * Hill(plan.kOli * aux_1 * aux_2);
 
 
     //
-    // Nkx
+    // Nkx (activation by Gli in the plan)
     //
 
-    // Activation by Gli
-    aux_1 = 1. + f_A * K_Gli_Nkx * h(0);
-    aux_1 /= 1. + K_Gli_Nkx * ( h(0) + h(1) );
-
     // Repression by Pax
-    aux_2 = 1./(1. + K_Pax_Nkx * x(0));
-    aux_2 *= aux_2;
+    aux_1 = 1./(1. + K_Pax_Nkx * x(0));
+    aux_1 *= aux_1;
 
     // Repression by Olig
-    aux_3 = 1./(1. + K_Oli_Nkx * x(1));
-    aux_3 *= aux_3;
+    aux_2 = 1./(1. + K_Oli_Nkx * x(1));
+    aux_2 *= aux_2;
 
     // Repression by Irx
-    aux_4 = 1./(1. + K_Irx_Nkx * x(3));
-    aux_4 *= aux_4;
+    aux_3 = 1./(1. + K_Irx_Nkx * x(3));
+    aux_3 *= aux_3;
 
-    prodR(2) = alpha_Nkx * Hill(K_Pol_Nkx * C_Pol * aux_1 * aux_2 * aux_3 * aux_4);
+    prodR(2) = alpha_Nkx * Hill(plan.kNkx * aux_1 * aux_2 * aux_3);
 
 
     //
@@ -357,7 +391,7 @@ void PONI::setProdR ()
     aux_2 = 1./(1. + K_Nkx_Irx * x(2));
     aux_2 *= aux_2;
 
-    prodR(3) = alpha_Irx * Hill(K_Pol_Irx * C_Pol * aux_1 * aux_2);
+    prodR(3) = alpha_Irx * Hill(plan.kIrx * aux_1 * aux_2);
 
 }
 
@@ -369,6 +403,187 @@ PONI_x_t PONI::getProdR()
 }
 
 
+//
+//  Jacobian of the drift:
+//  d prodR(i) / d x(j) = alpha_i * Hill'(z_i) * dz_i/dx(j), where z_i is
+//  the argument of the Hill function, and each repression 1/(1 + K x(j))^2
+//  contributes dz_i/dx(j) = - 2 K z_i / (1 + K x(j))
+//
+PONI_J_t PONI::getJacobian()
+{
+    PONI_J_t J = PONI_J_t::Zero();
+    double z, r1, r2, r3, g;
+
+    // Pax
+    r1 = 1./(1. + K_Oli_Pax * x(1));
+    r2 = 1./(1. + K_Nkx_Pax * x(2));
+    z = K_Pol_Pax * C_Pol * r1 * r1 * r2 * r2;
+    g = alpha_Pax * z /((1. + z)*(1. + z));
+    J(0,1) = - 2. * g * K_Oli_Pax * r1;
+    J(0,2) = - 2. * g * K_Nkx_Pax * r2;
+
+    // Olig
+    r1 = 1./(1. + K_Nkx_Oli * x(2));
+    r2 = 1./(1. + K_Irx_Oli * x(3));
+    z = (1. + f_A * K_Gli_Oli * h(0))/(1. + K_Gli_Oli * ( h(0) + h(1) ));
+    z *= K_Pol_Oli * C_Pol * r1 * r1 * r2 * r2;
+    g = alpha_Oli * z /((1. + z)*(1. + z));
+    J(1,2) = - 2. * g * K_Nkx_Oli * r1;
+    J(1,3) = - 2. * g * K_Irx_Oli * r2;
+
+    // Nkx
+    r1 = 1./(1. + K_Pax_Nkx * x(0));
+    r2 = 1./(1. + K_Oli_Nkx * x(1));
+    r3 = 1./(1. + K_Irx_Nkx * x(3));
+    z = (1. + f_A * K_Gli_Nkx * h(0))/(1. + K_Gli_Nkx * ( h(0) + h(1) ));
+    z *= K_Pol_Nkx * C_Pol * r1 * r1 * r2 * r2 * r3 * r3;
+    g = alpha_Nkx * z /((1. + z)*(1. + z));
+    J(2,0) = - 2. * g * K_Pax_Nkx * r1;
+    J(2,1) = - 2. * g * K_Oli_Nkx * r2;
+    J(2,3) = - 2. * g * K_Irx_Nkx * r3;
+
+    // Irx
+    r1 = 1./(1. + K_Oli_Irx * x(1));
+    r2 = 1./(1. + K_Nkx_Irx * x(2));
+    z = K_Pol_Irx * C_Pol * r1 * r1 * r2 * r2;
+    g = alpha_Irx * z /((1. + z)*(1. + z));
+    J(3,1) = - 2. * g * K_Oli_Irx * r1;
+    J(3,2) = - 2. * g * K_Nkx_Irx * r2;
+
+    // degradation
+    for (int i = 0; i < 4; i++)
+        J(i,i) -= delta;
+
+    return J;
+}
+
+
+//
+//  Names of the parameters, in the order of the columns of getParJacobian
+//
+const vector<string>& PONI::parameterNames()
+{
+    static const vector<string> names = {
+        "lambdaConc", "lambdaTime",
+        "K_Pol_Pax", "K_Pol_Oli", "K_Pol_Nkx", "K_Pol_Irx",
+        "K_Gli_Oli", "K_Gli_Nkx",
+        "K_Oli_Pax", "K_Oli_Nkx", "K_Nkx_Oli", "K_Pax_Nkx", "K_Nkx_Pax",
+        "K_Irx_Oli", "K_Oli_Irx", "K_Irx_Nkx", "K_Nkx_Irx",
+        "f_A", "C_Pol",
+        "alpha_Pax", "alpha_Oli", "alpha_Nkx", "alpha_Irx",
+        "delta", "Omega"
+    };
+    return names;
+}
+
+
+//
+//  Derivatives of the drift w.r.t. the parameters: first w.r.t. the
+//  rescaled constants (D, same columns), then through the rescaling by
+//  lambdaConc and lambdaTime. With z_i the argument of the Hill function,
+//  d prodR(i) = alpha_i/(1 + z_i)^2 dz_i + Hill(z_i) d alpha_i
+//
+PONI_P_t PONI::getParJacobian()
+{
+    enum { LC, LT, PPAX, POLI, PNKX, PIRX, GOLI, GNKX,
+           OLI_PAX, OLI_NKX, NKX_OLI, PAX_NKX, NKX_PAX,
+           IRX_OLI, OLI_IRX, IRX_NKX, NKX_IRX,
+           FA, CPOL, APAX, AOLI, ANKX, AIRX, DELTA, OMEGA };
+
+    PONI_P_t D = PONI_P_t::Zero();
+    double r1, r2, r3, z, zr, a, s, gp;
+
+    // Pax
+    r1 = 1./(1. + K_Oli_Pax * x(1));
+    r2 = 1./(1. + K_Nkx_Pax * x(2));
+    zr = r1 * r1 * r2 * r2;
+    z = K_Pol_Pax * C_Pol * zr;
+    gp = alpha_Pax /((1. + z)*(1. + z));
+    D(0,PPAX) = gp * C_Pol * zr;
+    D(0,CPOL) = gp * K_Pol_Pax * zr;
+    D(0,OLI_PAX) = - 2. * gp * z * x(1) * r1;
+    D(0,NKX_PAX) = - 2. * gp * z * x(2) * r2;
+    D(0,APAX) = Hill(z);
+
+    // Olig
+    r1 = 1./(1. + K_Nkx_Oli * x(2));
+    r2 = 1./(1. + K_Irx_Oli * x(3));
+    s = h(0) + h(1);
+    a = (1. + f_A * K_Gli_Oli * h(0))/(1. + K_Gli_Oli * s);
+    zr = r1 * r1 * r2 * r2;
+    z = K_Pol_Oli * C_Pol * a * zr;
+    gp = alpha_Oli /((1. + z)*(1. + z));
+    D(1,POLI) = gp * C_Pol * a * zr;
+    D(1,CPOL) = gp * K_Pol_Oli * a * zr;
+    D(1,GOLI) = gp * K_Pol_Oli * C_Pol * zr * (f_A * h(0) - s * a)/(1. + K_Gli_Oli * s);
+    D(1,FA) = gp * K_Pol_Oli * C_Pol * zr * K_Gli_Oli * h(0)/(1. + K_Gli_Oli * s);
+    D(1,NKX_OLI) = - 2. * gp * z * x(2) * r1;
+    D(1,IRX_OLI) = - 2. * gp * z * x(3) * r2;
+    D(1,AOLI) = Hill(z);
+
+    // Nkx
+    r1 = 1./(1. + K_Pax_Nkx * x(0));
+    r2 = 1./(1. + K_Oli_Nkx * x(1));
+    r3 = 1./(1. + K_Irx_Nkx * x(3));
+    a = (1. + f_A * K_Gli_Nkx * h(0))/(1. + K_Gli_Nkx * s);
+    zr = r1 * r1 * r2 * r2 * r3 * r3;
+    z = K_Pol_Nkx * C_Pol * a * zr;
+    gp = alpha_Nkx /((1. + z)*(1. + z));
+    D(2,PNKX) = gp * C_Pol * a * zr;
+    D(2,CPOL) = gp * K_Pol_Nkx * a * zr;
+    D(2,GNKX) = gp * K_Pol_Nkx * C_Pol * zr * (f_A * h(0) - s * a)/(1. + K_Gli_Nkx * s);
+    D(2,FA) = gp * K_Pol_Nkx * C_Pol * zr * K_Gli_Nkx * h(0)/(1. + K_Gli_Nkx * s);
+    D(2,PAX_NKX) = - 2. * gp * z * x(0) * r1;
+    D(2,OLI_NKX) = - 2. * gp * z * x(1) * r2;
+    D(2,IRX_NKX) = - 2. * gp * z * x(3) * r3;
+    D(2,ANKX) = Hill(z);
+
+    // Irx
+    r1 = 1./(1. + K_Oli_Irx * x(1));
+    r2 = 1./(1. + K_Nkx_Irx * x(2));
+    zr = r1 * r1 * r2 * r2;
+    z = K_Pol_Irx * C_Pol * zr;
+    gp = alpha_Irx /((1. + z)*(1. + z));
+    D(3,PIRX) = gp * C_Pol * zr;
+    D(3,CPOL) = gp * K_Pol_Irx * zr;
+    D(3,OLI_IRX) = - 2. * gp * z * x(1) * r1;
+    D(3,NKX_IRX) = - 2. * gp * z * x(2) * r2;
+    D(3,AIRX) = Hill(z);
+
+    // degradation
+    D.col(DELTA) = - x;
+
+    // rescaling: K = K'/lambdaConc, C_Pol = C_Pol' lambdaConc,
+    // alpha = alpha' lambdaConc/lambdaTime, delta = delta'/lambdaTime
+    const double* K[] = {&K_Pol_Pax, &K_Pol_Oli, &K_Pol_Nkx, &K_Pol_Irx,
+        &K_Gli_Oli, &K_Gli_Nkx, &K_Oli_Pax, &K_Oli_Nkx, &K_Nkx_Oli,
+        &K_Pax_Nkx, &K_Nkx_Pax, &K_Irx_Oli, &K_Oli_Irx, &K_Irx_Nkx, &K_Nkx_Irx};
+    const double* A[] = {&alpha_Pax, &alpha_Oli, &alpha_Nkx, &alpha_Irx};
+
+    PONI_P_t P = D;
+    P.col(LC).setZero();
+    P.col(LT).setZero();
+    for (int k = 0; k < 15; k++)
+    {
+        P.col(PPAX + k) = D.col(PPAX + k) / lambdaConc;
+        P.col(LC) -= D.col(PPAX + k) * (*K[k]) / lambdaConc;
+    }
+    P.col(CPOL) = D.col(CPOL) * lambdaConc;
+    P.col(LC) += D.col(CPOL) * C_Pol / lambdaConc;
+    for (int k = 0; k < 4; k++)
+    {
+        P.col(APAX + k) = D.col(APAX + k) * lambdaConc / lambdaTime;
+        P.col(LC) += D.col(APAX + k) * (*A[k]) / lambdaConc;
+        P.col(LT) -= D.col(APAX + k) * (*A[k]) / lambdaTime;
+    }
+    P.col(DELTA) = D.col(DELTA) / lambdaTime;
+    P.col(LT) -= D.col(DELTA) * delta / lambdaTime;
+    P.col(OMEGA).setZero();
+
+    return P;
+}
+
+
 // force
 void PONI::setDrift ()
 {
@@ -395,14 +610,83 @@ void PONI::evolve (double dt, bool stoch)
 {
     PONI_x_t xp, xpp;
 
+    STATS_ADD(steps,1);
     setDrift();       // this also sets the necessary variables for noise
     xpp = x + drift * dt;
     xp = xpp;
     if (stoch) {
+        STATS_ADD(redraws,-1);   // the first draw is not a redraw
         do {
+            STATS_ADD(redraws,1);
             setNoise();
             xp = xpp + sqrt(dt/Omega) * noise;
         } while ( (xp(0) < 0.) || (xp(1) < 0.) || (xp(2) < 0.) || (xp(3) < 0.) );
     }
     x = xp;
+}
+
+
+/*
+ *     ####   ###   #   #  #####
+ *    #      #   #  #   #  #
+ *     ###   #####  #   #  ####
+ *        #  #   #   # #   #
+ *    ####   #   #    #    #####
+ */
+
+//  Write state, effector and parameters in binary form
+void PONI::write (ostream& os) const
+{
+    os.write((const char*) x.data(), 4*sizeof(double));
+    os.write((const char*) h.data(), 2*sizeof(double));
+
+    int npars = pars.size();
+    os.write((const char*) &npars, sizeof(int));
+    for( const auto& n : pars )
+    {
+        int len = n.first.size();
+        os.write((const char*) &len, sizeof(int));
+        os.write(n.first.data(), len);
+        os.write((const char*) &n.second, sizeof(double));
+    }
+}
+
+
+//  Read what has been written by PONI::write
+void PONI::read (istream& is)
+{
+    is.read((char*) x.data(), 4*sizeof(double));
+    is.read((char*) h.data(), 2*sizeof(double));
+
+    int npars = 0;
+    is.read((char*) &npars, sizeof(int));
+    for (int k = 0; k < npars && is; k++)
+    {
+        int len = 0;
+        double val;
+        is.read((char*) &len, sizeof(int));
+        if (len <= 0 || len > 256)
+        {
+            is.setstate(ios::failbit);
+            break;
+        }
+        string key(len, ' ');
+        is.read(&key[0], len);
+        is.read((char*) &val, sizeof(double));
+        if (pars.find(key) == pars.end())
+        {
+            cout << "error: read (PONI): invalid parameter name \""
+                 << key << "\"\n";
+            exit(EXIT_FAILURE);
+        }
+        pars[key] = val;
+    }
+
+    if (!is)
+    {
+        cout << "error: read (PONI): corrupted input\n";
+        exit(EXIT_FAILURE);
+    }
+
+    assignParameters();
 }
\ No newline at end of file
@@ -0,0 +1,321 @@
+/******************************************************************************
+ *
+ *  poni_c.cc
+ *
+ *  C interface of libponi.so (see ../../include/grn/poni_c.h).
+ *
+ *  The arguments are checked here, so that the errors of the C++ classes
+ *  (which exit) are never reached, and no exception crosses the interface.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define PONI_C_CC
+
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <new>
+#include "random.h"
+#include "grn/poni.h"
+#include "grn/batch.h"
+#include "grn/schedule.h"
+#include "grn/poni_c.h"
+
+using namespace std;
+
+
+struct poni_params {
+    PONI cell;
+};
+
+struct poni_batch {
+    PONIbatch b;
+    poni_batch (const PONI& cell, int n, double* x) : b(cell, n, x) {}
+};
+
+struct poni_schedule {
+    Schedule s;
+    poni_schedule (const vector<double>& t, const SCHEDULE_h_t& h, int mode)
+        : s(t, h, mode) {}
+};
+
+
+static bool validSchedule (const vector<double>& t, const SCHEDULE_h_t& h, int mode)
+{
+    if (t.empty() || t.size() != h.size())
+        return false;
+    if (mode != PONI_SCHEDULE_CONSTANT && mode != PONI_SCHEDULE_LINEAR
+        && mode != PONI_SCHEDULE_SPLINE)
+        return false;
+    for (unsigned j = 0; j < t.size(); j++)
+        if (!std::isfinite(t[j]) || (j > 0 && !(t[j] > t[j-1])))
+            return false;
+    return true;
+}
+
+
+static bool validName (const char* name)
+{
+    if (name == NULL)
+        return false;
+    const vector<string>& names = PONI::parameterNames();
+    return find(names.begin(), names.end(), string(name)) != names.end();
+}
+
+
+extern "C" {
+
+int poni_abi_version (void)
+{
+    return PONI_ABI_VERSION;
+}
+
+void poni_seed (int seed)
+{
+    seed = max(1, seed);
+    rlxd_init(1, seed);
+    rlxdv_init(BATCH_STREAMS, 1, min(seed, INT_MAX - BATCH_STREAMS + 1));
+}
+
+
+poni_params *poni_params_new (void)
+{
+    try {
+        return new poni_params;
+    } catch (...) {
+        return NULL;
+    }
+}
+
+void poni_params_free (poni_params *p)
+{
+    delete p;
+}
+
+int poni_params_load (poni_params *p, const char *filename)
+{
+    if (p == NULL || filename == NULL)
+        return PONI_EINVAL;
+
+    ifstream parf(filename);
+    if (!parf)
+        return PONI_EIO;
+
+    // all names are checked before any parameter is changed
+    vector<pair<string,double>> kv;
+    string key;
+    double val;
+    while (parf >> key >> val)
+    {
+        if (!validName(key.c_str()))
+            return PONI_EINVAL;
+        kv.push_back(make_pair(key, val));
+    }
+    if (!parf.eof())
+        return PONI_EIO;
+
+    for (auto& e : kv)
+        p->cell.setParameters(e.first, e.second);
+    return PONI_OK;
+}
+
+int poni_params_set (poni_params *p, const char *name, double value)
+{
+    if (p == NULL || !validName(name))
+        return PONI_EINVAL;
+    p->cell.setParameters(name, value);
+    return PONI_OK;
+}
+
+int poni_params_get (const poni_params *p, const char *name, double *value)
+{
+    if (p == NULL || value == NULL || !validName(name))
+        return PONI_EINVAL;
+    *value = p->cell.getParameter(name);
+    return PONI_OK;
+}
+
+
+poni_batch *poni_batch_new (const poni_params *p, int n, double *state)
+{
+    if (p == NULL || n < 1)
+        return NULL;
+    try {
+        return new poni_batch(p->cell, n, state);
+    } catch (...) {
+        return NULL;
+    }
+}
+
+void poni_batch_free (poni_batch *b)
+{
+    delete b;
+}
+
+int poni_batch_size (const poni_batch *b)
+{
+    return (b == NULL) ? 0 : b->b.size();
+}
+
+double *poni_batch_state (poni_batch *b)
+{
+    return (b == NULL) ? NULL : b->b.state();
+}
+
+int poni_batch_set_effector (poni_batch *b, double gliA, double gliR)
+{
+    if (b == NULL)
+        return PONI_EINVAL;
+    b->b.setEffector(PONI_h_t(gliA, gliR));
+    return PONI_OK;
+}
+
+int poni_batch_set_effectors (poni_batch *b, const double *h)
+{
+    if (b == NULL || h == NULL)
+        return PONI_EINVAL;
+    b->b.setEffectors(h);
+    return PONI_OK;
+}
+
+int poni_batch_set_parameters (poni_batch *b, const char *name,
+                               const double *values)
+{
+    if (b == NULL || values == NULL || !validName(name)
+        || strcmp(name, "lambdaConc") == 0 || strcmp(name, "lambdaTime") == 0)
+        return PONI_EINVAL;
+    try {
+        b->b.setParameters(name, values);
+    } catch (...) {
+        return PONI_EFAIL;
+    }
+    return PONI_OK;
+}
+
+int poni_batch_advance (poni_batch *b, double T, double dt, int stochastic)
+{
+    if (b == NULL || !(dt > 0.) || !(T >= 0.) || std::isinf(T))
+        return PONI_EINVAL;
+    if (b->b.delayed() && fabs(dt - b->b.delayStep()) > 1.e-12*dt)
+        return PONI_EINVAL;
+    try {
+        b->b.advance(T, dt, stochastic != 0);
+    } catch (...) {
+        return PONI_EFAIL;
+    }
+    return PONI_OK;
+}
+
+int poni_batch_set_delays (poni_batch *b, const double *tau, double dt)
+{
+    if (b == NULL || tau == NULL || !(dt > 0.) || std::isinf(dt))
+        return PONI_EINVAL;
+    for (int k = 0; k < 4; k++)
+        if (!(tau[k] >= 0.) || std::isinf(tau[k]))
+            return PONI_EINVAL;
+    try {
+        b->b.setDelays(PONI_x_t(tau[0], tau[1], tau[2], tau[3]), dt);
+    } catch (...) {
+        return PONI_EFAIL;
+    }
+    return PONI_OK;
+}
+
+int poni_batch_read_state (const poni_batch *b, double *x)
+{
+    if (b == NULL || x == NULL)
+        return PONI_EINVAL;
+    const double* s = b->b.state();
+    if (x != s)
+        memcpy(x, s, 4*b->b.size()*sizeof(double));
+    return PONI_OK;
+}
+
+int poni_batch_write_state (poni_batch *b, const double *x)
+{
+    if (b == NULL || x == NULL)
+        return PONI_EINVAL;
+    double* s = b->b.state();
+    if (x != s)
+        memcpy(s, x, 4*b->b.size()*sizeof(double));
+    return PONI_OK;
+}
+
+
+poni_schedule *poni_schedule_new (const double *t, const double *h, int m,
+                                  int interpolation)
+{
+    if (t == NULL || h == NULL || m < 1)
+        return NULL;
+    try {
+        vector<double> tv(t, t + m);
+        SCHEDULE_h_t hv(m);
+        for (int j = 0; j < m; j++)
+            hv[j] = PONI_h_t(h[j], h[m + j]);
+        if (!validSchedule(tv, hv, interpolation))
+            return NULL;
+        return new poni_schedule(tv, hv, interpolation);
+    } catch (...) {
+        return NULL;
+    }
+}
+
+poni_schedule *poni_schedule_load (const char *filename, int interpolation)
+{
+    if (filename == NULL)
+        return NULL;
+    try {
+        ifstream is(filename);
+        if (!is)
+            return NULL;
+        vector<double> tv;
+        SCHEDULE_h_t hv;
+        string line;
+        while (getline(is, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            istringstream ls(line);
+            double tk;
+            PONI_h_t hk;
+            if (!(ls >> tk >> hk(0) >> hk(1)))
+                return NULL;
+            tv.push_back(tk);
+            hv.push_back(hk);
+        }
+        if (!validSchedule(tv, hv, interpolation))
+            return NULL;
+        return new poni_schedule(tv, hv, interpolation);
+    } catch (...) {
+        return NULL;
+    }
+}
+
+void poni_schedule_free (poni_schedule *s)
+{
+    delete s;
+}
+
+int poni_batch_advance_schedule (poni_batch *b, const poni_schedule *s,
+                                 double t0, double T, double dt, int stochastic)
+{
+    if (b == NULL || s == NULL || !(dt > 0.) || !(T >= 0.) || std::isinf(T)
+        || !std::isfinite(t0))
+        return PONI_EINVAL;
+    if (b->b.delayed() && fabs(dt - b->b.delayStep()) > 1.e-12*dt)
+        return PONI_EINVAL;
+    try {
+        b->b.advance(T, dt, stochastic != 0, s->s, t0);
+    } catch (...) {
+        return PONI_EFAIL;
+    }
+    return PONI_OK;
+}
+
+}
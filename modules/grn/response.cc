@@ -0,0 +1,277 @@
+/******************************************************************************
+ *
+ *  response.cc
+ *
+ *  Implementation of the table of responses of a PONI cell to Gli.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define RESPONSE_CC
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "grn/poni.h"
+#include "grn/response.h"
+
+using namespace std;
+
+static const char magic[8] = {'P','O','N','I','R','S','P','1'};
+
+
+ResponseTable::ResponseTable ()
+{
+    T = 300.;
+    dt = .01;
+    gMin = 1.e-4;
+    gMax = 1.;
+    n0 = 64;
+    tol = 1.e-3;
+    dlogMin = 1.e-6;
+}
+
+
+// final state of a cell starting as 'start', at constant GliA = g, GliR = 1-g
+// (the same steps as PONIpattern, in the fused kernel)
+PONI_x_t ResponseTable::reach (const PONI& start, double gl) const
+{
+    long steps = 0;
+    for (double t = 0.; t < T; t += dt)
+        steps++;
+
+    PONI c = start;
+    c.setEffector(gl, 1. - gl);
+    c.integrate(steps, dt, false);
+    return c.getState();
+}
+
+
+int ResponseTable::entry (const PONI& start, const PONI& ventral, double gl)
+{
+    PONI_x_t xs = reach(start, gl);
+    PONI_x_t xv = reach(ventral, gl);
+
+    g.push_back(gl);
+    x.push_back(xs);
+    bistable.push_back((xs - xv).cwiseAbs().maxCoeff() > tol);
+    return g.size() - 1;
+}
+
+
+bool ResponseTable::differ (int i, int j) const
+{
+    return (x[i] - x[j]).cwiseAbs().maxCoeff() > tol
+        || bistable[i] != bistable[j];
+}
+
+
+// bisection (in log(g)) of the interval between entries i and j
+void ResponseTable::refine (const PONI& start, const PONI& ventral, int i, int j)
+{
+    if (!differ(i, j) || log(g[j]/g[i]) <= dlogMin)
+        return;
+
+    int m = entry(start, ventral, sqrt(g[i]*g[j]));
+    refine(start, ventral, i, m);
+    refine(start, ventral, m, j);
+}
+
+
+void ResponseTable::build (const PONI& start)
+{
+    g.clear();
+    x.clear();
+    bistable.clear();
+
+    // state at the ventral end, the other side of bistable regions
+    PONI ventral = start;
+    ventral.setState(reach(start, gMax));
+
+    vector<int> grid(n0 + 1);
+    double u0 = log(gMin), du = (log(gMax) - log(gMin))/n0;
+    for (int k = 0; k <= n0; k++)
+        grid[k] = entry(start, ventral, (k == n0) ? gMax : exp(u0 + k*du));
+    for (int k = 0; k < n0; k++)
+        refine(start, ventral, grid[k], grid[k+1]);
+
+    // sort the entries by g
+    vector<int> idx(g.size());
+    iota(idx.begin(), idx.end(), 0);
+    sort(idx.begin(), idx.end(), [&](int a, int b) { return g[a] < g[b]; });
+
+    vector<double> gs;
+    vector<PONI_x_t, aligned_allocator<PONI_x_t>> xs;
+    vector<char> bs;
+    for (int i : idx)
+    {
+        gs.push_back(g[i]);
+        xs.push_back(x[i]);
+        bs.push_back(bistable[i]);
+    }
+    g.swap(gs);
+    x.swap(xs);
+    bistable.swap(bs);
+
+    key = makeKey(start);
+}
+
+
+PONI_x_t ResponseTable::lookup (double gl, bool* bist) const
+{
+    if (g.empty())
+    {
+        cout << "error: ResponseTable: lookup in an empty table\n";
+        exit(EXIT_FAILURE);
+    }
+
+    int n = g.size();
+    int i;
+    double w;
+
+    if (n == 1)
+    {
+        if (bist != NULL) *bist = bistable[0];
+        return x[0];
+    }
+
+    if (gl <= g[0])
+    {
+        i = 0;
+        w = 0.;
+    }
+    else if (gl >= g[n-1])
+    {
+        i = n - 2;
+        w = 1.;
+    }
+    else
+    {
+        i = upper_bound(g.begin(), g.end(), gl) - g.begin() - 1;
+        w = log(gl/g[i])/log(g[i+1]/g[i]);
+    }
+
+    // across a jump take the nearest entry
+    if (differ(i, i+1))
+        w = (w < .5) ? 0. : 1.;
+
+    if (bist != NULL)
+        *bist = bistable[(w < .5) ? i : i+1];
+
+    if (w == 0.)
+        return x[i];
+    if (w == 1.)
+        return x[i+1];
+    return (1. - w)*x[i] + w*x[i+1];
+}
+
+
+/*
+ *     ####   ###   #   #  #####
+ *    #      #   #  #   #  #
+ *     ###   #####  #   #  ####
+ *        #  #   #   # #   #
+ *    ####   #   #    #    #####
+ */
+
+string ResponseTable::makeKey (const PONI& start) const
+{
+    ostringstream os(ios::out | ios::binary);
+    double settings[6] = {T, dt, gMin, gMax, tol, dlogMin};
+    os.write((const char*) settings, sizeof(settings));
+    os.write((const char*) &n0, sizeof(int));
+
+    // state, effector and parameters in a fixed order (PONI::write follows
+    // that of the map, which may change with the standard library)
+    PONI_x_t x0 = start.getState();
+    PONI_h_t h0 = start.getEffector();
+    os.write((const char*) x0.data(), 4*sizeof(double));
+    os.write((const char*) h0.data(), 2*sizeof(double));
+    for (const string& name : PONI::parameterNames())
+    {
+        double v = start.getParameter(name);
+        os.write((const char*) &v, sizeof(double));
+    }
+    return os.str();
+}
+
+
+void ResponseTable::save (const char* filename) const
+{
+    string tmp = string(filename) + ".tmp";
+    ofstream os(tmp.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!os)
+    {
+        cout << "error: ResponseTable: cannot write \"" << tmp << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    int nkey = key.size();
+    int n = g.size();
+
+    os.write(magic, 8);
+    os.write((const char*) &nkey, sizeof(int));
+    os.write(key.data(), nkey);
+    os.write((const char*) &n, sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        os.write((const char*) &g[i], sizeof(double));
+        os.write((const char*) x[i].data(), 4*sizeof(double));
+        os.write(&bistable[i], sizeof(char));
+    }
+
+    os.close();
+    if (!os || rename(tmp.c_str(), filename) != 0)
+    {
+        cout << "error: ResponseTable: cannot write \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+bool ResponseTable::load (const char* filename, const PONI& start)
+{
+    ifstream is(filename, ios::in | ios::binary);
+    if (!is)
+        return false;
+
+    char m[8];
+    int nkey, n;
+    is.read(m, 8);
+    is.read((char*) &nkey, sizeof(int));
+    if (!is || memcmp(m, magic, 8) != 0 || nkey < 0)
+        return false;
+
+    string k(nkey, '\0');
+    is.read(&k[0], nkey);
+    is.read((char*) &n, sizeof(int));
+    if (!is || k != makeKey(start) || n < 1)
+        return false;
+
+    vector<double> gs(n);
+    vector<PONI_x_t, aligned_allocator<PONI_x_t>> xs(n);
+    vector<char> bs(n);
+    for (int i = 0; i < n; i++)
+    {
+        is.read((char*) &gs[i], sizeof(double));
+        is.read((char*) xs[i].data(), 4*sizeof(double));
+        is.read(&bs[i], sizeof(char));
+    }
+    if (!is)
+        return false;
+
+    g.swap(gs);
+    x.swap(xs);
+    bistable.swap(bs);
+    key.swap(k);
+    return true;
+}
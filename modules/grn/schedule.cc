@@ -0,0 +1,184 @@
+/******************************************************************************
+ *
+ *  schedule.cc
+ *
+ *  Implementation of the schedules of the effectors.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define SCHEDULE_CC
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+#include <vector>
+#include <algorithm>
+#include "grn/poni.h"
+#include "grn/schedule.h"
+
+using namespace std;
+
+
+Schedule::Schedule (const vector<double>& times, const SCHEDULE_h_t& values,
+                    int interpolation)
+    : mode(interpolation), t(times), v(values)
+{
+    build();
+}
+
+
+Schedule::Schedule (const char* filename, int interpolation)
+    : mode(interpolation)
+{
+    ifstream is(filename);
+    if (!is)
+    {
+        cout << "error: Schedule: cannot open \"" << filename << "\"\n";
+        exit(EXIT_FAILURE);
+    }
+
+    string line;
+    while (getline(is, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        istringstream ls(line);
+        double tk;
+        PONI_h_t hk;
+        if (!(ls >> tk >> hk(0) >> hk(1)))
+        {
+            cout << "error: Schedule: invalid line in \"" << filename << "\":  "
+                 << line << "\n";
+            exit(EXIT_FAILURE);
+        }
+        t.push_back(tk);
+        v.push_back(hk);
+    }
+    is.close();
+
+    build();
+}
+
+
+//
+//  coefficients of the segments (natural spline: second derivatives from
+//  the tridiagonal system with zero curvature at the ends)
+//
+void Schedule::build ()
+{
+    const int m = t.size();
+    if (m < 1 || (int) v.size() != m)
+    {
+        cout << "error: Schedule: knots and values do not match\n";
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 1; i < m; i++)
+        if (!(t[i] > t[i-1]))
+        {
+            cout << "error: Schedule: the knots must be increasing\n";
+            exit(EXIT_FAILURE);
+        }
+    if (mode != SCHEDULE_CONSTANT && mode != SCHEDULE_LINEAR && mode != SCHEDULE_SPLINE)
+    {
+        cout << "error: Schedule: invalid interpolation\n";
+        exit(EXIT_FAILURE);
+    }
+
+    b.assign(m, PONI_h_t::Zero());
+    c.assign(m, PONI_h_t::Zero());
+    d.assign(m, PONI_h_t::Zero());
+
+    if (mode == SCHEDULE_LINEAR)
+        for (int i = 0; i < m - 1; i++)
+            b[i] = (v[i+1] - v[i])/(t[i+1] - t[i]);
+
+    if (mode == SCHEDULE_SPLINE && m > 2)
+    {
+        // M_i = second derivatives / 2 (= c_i), M_0 = M_m-1 = 0
+        vector<double> l(m, 0.);
+        SCHEDULE_h_t z(m, PONI_h_t::Zero());
+        for (int i = 1; i < m - 1; i++)
+        {
+            double h0 = t[i] - t[i-1], h1 = t[i+1] - t[i];
+            PONI_h_t r = 3.*((v[i+1] - v[i])/h1 - (v[i] - v[i-1])/h0);
+            double diag = 2.*(h0 + h1) - h0*l[i-1];
+            l[i] = h1/diag;
+            z[i] = (r - h0*z[i-1])/diag;
+        }
+        for (int i = m - 2; i >= 1; i--)
+            c[i] = z[i] - l[i]*c[i+1];
+        for (int i = 0; i < m - 1; i++)
+        {
+            double hi = t[i+1] - t[i];
+            b[i] = (v[i+1] - v[i])/hi - hi*(c[i+1] + 2.*c[i])/3.;
+            d[i] = (c[i+1] - c[i])/(3.*hi);
+        }
+    }
+    else if (mode == SCHEDULE_SPLINE)
+        for (int i = 0; i < m - 1; i++)
+            b[i] = (v[i+1] - v[i])/(t[i+1] - t[i]);
+
+    flat.assign(m, 1);
+    for (int i = 0; i < m - 1; i++)
+        flat[i] = (b[i].isZero(0.) && c[i].isZero(0.) && d[i].isZero(0.));
+}
+
+
+int Schedule::segment (double time) const
+{
+    // first knot after time, minus one
+    return (upper_bound(t.begin(), t.end(), time) - t.begin()) - 1;
+}
+
+
+double Schedule::segmentEnd (int seg) const
+{
+    if (seg + 1 >= (int) t.size())
+        return INFINITY;
+    return t[seg + 1];
+}
+
+
+bool Schedule::constant (int seg) const
+{
+    return (seg < 0 || seg >= (int) t.size() - 1) ? true : flat[seg];
+}
+
+
+PONI_h_t Schedule::at (double time) const
+{
+    int i = segment(time);
+    if (i < 0)
+        return v.front();
+    if (i >= (int) t.size() - 1)
+        return v.back();
+
+    double s = time - t[i];
+    return v[i] + s*(b[i] + s*(c[i] + s*d[i]));
+}
+
+
+long Schedule::stepsInSegment (double t0, double dt, long k) const
+{
+    int seg = segment(t0 + k*dt);
+    if (!constant(seg))
+        return 1;
+
+    double te = segmentEnd(seg);
+    if (std::isinf(te))
+        return LONG_MAX;
+
+    // steps k...k+m-1 start before te
+    long m = max(1L, (long) ceil((te - t0)/dt) - k);
+    while (m > 1 && t0 + (k + m - 1)*dt >= te)
+        m--;
+    while (t0 + (k + m)*dt < te)
+        m++;
+    return m;
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ *  sensitivity.cc
+ *
+ *  Forward sensitivities and discrete adjoint of the PONI integrator.
+ *
+ *  Author: Alberto Pezzotta (alberto.pezzotta [AT] crick.ac.uk)
+ *
+ *****************************************************************************/
+
+#define SENSITIVITY_CC
+
+#include <iostream>
+#include <vector>
+#include <Eigen/Dense>
+#include "grn/poni.h"
+#include "grn/sensitivity.h"
+
+using namespace std;
+using namespace Eigen;
+
+
+void forwardSensitivity (PONI& cell, double T, double dt, PONI_P_t& S)
+{
+    for (double t = 0.; t < T; t += dt)
+    {
+        // derivatives at the beginning of the step, as in the Euler step
+        PONI_J_t J = cell.getJacobian();
+        PONI_P_t P = cell.getParJacobian();
+        S += dt * (J * S + P);
+        cell.evolve(dt, false);
+    }
+}
+
+
+typedef vector<PONI_x_t, aligned_allocator<PONI_x_t>> traj_t;
+
+// forward pass, storing the states at the beginning of each step;
+// returns the final state
+static PONI_x_t record (const PONI& cell, double T, double dt, traj_t& traj)
+{
+    PONI c = cell;
+    for (double t = 0.; t < T; t += dt)
+    {
+        traj.push_back(c.getState());
+        c.evolve(dt, false);
+    }
+    return c.getState();
+}
+
+// backward pass for x_{n+1} = x_n + dt F(x_n, p)
+static PONI_g_t backward (const PONI& cell, double dt, const traj_t& traj,
+                          const PONI_x_t& lambdaT, PONI_x_t* lambda0)
+{
+    PONI c = cell;
+    PONI_x_t lambda = lambdaT;
+    PONI_g_t grad = PONI_g_t::Zero();
+    for (int n = traj.size() - 1; n >= 0; n--)
+    {
+        c.setState(traj[n]);
+        grad += dt * lambda.transpose() * c.getParJacobian();
+        lambda += dt * c.getJacobian().transpose() * lambda;
+    }
+
+    if (lambda0 != NULL)
+        *lambda0 = lambda;
+    return grad;
+}
+
+
+PONI_g_t adjointGradient (const PONI& cell, double T, double dt,
+                          const PONI_x_t& lambdaT, PONI_x_t* lambda0)
+{
+    traj_t traj;
+    record(cell, T, dt, traj);
+    return backward(cell, dt, traj, lambdaT, lambda0);
+}
+
+
+PONI_g_t adjointGradient (const PONI& cell, double T, double dt,
+                          PONI_loss_t loss, double* value, PONI_x_t* lambda0)
+{
+    traj_t traj;
+    PONI_x_t lambdaT;
+    double L = loss(record(cell, T, dt, traj), lambdaT);
+    if (value != NULL)
+        *value = L;
+
+    return backward(cell, dt, traj, lambdaT, lambda0);
+}
@@ -15,6 +15,12 @@
 *     Generates n double-precision Gaussian random numbers x with distribution
 *     proportional to exp(-x^2) and assigns them to rd[0],..,rd[n-1]
 *
+*   void gauss_dblev(double rd[],int n)
+*     Generates n double-precision Gaussian random numbers of each stream of
+*     ranlxdv and assigns them to rd[k*ns+s] (k=0,..,n-1, s=0,..,ns-1 with
+*     ns=rlxdv_streams()); stream s is the sequence of gauss_dble after
+*     rlxd_init(level,seed+s), and all the streams are transformed together
+*
 * Version 1.0
 * Author: Martin Luescher <luscher@mail.cern.ch>
 *
@@ -82,6 +88,46 @@ void gauss_dble(double rd[],int n)
 }
 
 
+void gauss_dblev(double rd[],int n)
+{
+   int k,s,ns,m,j;
+   double ud[2*8*RLXDV_MAX],*u;
+   double x1,x2,rho,y1,y2;
+
+   ranlxdv(ud,0);
+   ns=rlxdv_streams();
+
+   for (k=0;k<n;)
+   {
+      /* uniform numbers of up to 8 pairs of each stream at once */
+      m=(n-k+1)/2;
+      if (m>8)
+         m=8;
+      ranlxdv(ud,2*m);
+
+      for (j=0;j<m;j++)
+      {
+         u=ud+2*j*ns;
+
+         for (s=0;s<ns;s++)
+         {
+            x1=u[s];
+            x2=u[ns+s];
+            rho=-log(1.0-x1);
+            rho=sqrt(rho);
+            x2*=2.0*PI;
+            y1=sqrt(2.)*rho*sin(x2);
+            y2=sqrt(2.)*rho*cos(x2);
+            rd[k*ns+s]=y1;
+            if (k+1<n)
+               rd[(k+1)*ns+s]=y2;
+         }
+         k+=2;
+      }
+   }
+}
+
+
 double gaussdistr(double x)
 {
 	return exp(-x*x/2.)/sqrt(2*PI);
@@ -34,6 +34,10 @@
 *   void rlxd_reset(int state[])
 *     Resets the generator to the state defined by the array state[N]
 *
+* The state of the generator is private to each thread: threads other than
+* the main one start from the default initialization (rlxd_init(1,1)) and
+* should call rlxd_init with their own seed
+*
 * Version: 3.0
 * Author: Martin Luescher <luscher@mail.cern.ch>
 *
@@ -46,6 +50,9 @@
 #include <stdio.h>
 #include <math.h>
 #include "start.h"
+#include "stats.h"
+
+#define TLS __thread
 
 
 int rlxd_seed(){
@@ -59,7 +66,7 @@ int rlxd_seed(){
 }
 
 
-#if ((defined SSE)||(defined SSE2))
+#if ((defined SSE)||(defined SSE2))&&((defined __x86_64__)||(defined __i386__))
 
 typedef struct
 {
@@ -71,10 +78,10 @@ typedef struct
    vec_t c1,c2;
 } dble_vec_t __attribute__ ((aligned (16)));
 
-static int init=0,pr,prm,ir,jr,is,is_old,next[96];
-static vec_t one,one_bit,carry;
+static TLS int init=0,pr,prm,ir,jr,is,is_old,next[96];
+static TLS vec_t one,one_bit,carry;
 
-static union
+static TLS union
 {
    dble_vec_t vec[12];
    float num[96];
@@ -255,6 +262,8 @@ void ranlxd(double r[],int n)
    if (init==0)
       rlxd_init(1,1);
 
+   STATS_ADD(rng,n);
+
    for (k=0;k<n;k++) 
    {
       is=next[is];
@@ -354,11 +363,11 @@ typedef struct
    vec_t c1,c2;
 } dble_vec_t;
 
-static int init=0,pr,prm,ir,jr,is,is_old,next[96];
-static double one_bit;
-static vec_t carry;
+static TLS int init=0,pr,prm,ir,jr,is,is_old,next[96];
+static TLS double one_bit;
+static TLS vec_t carry;
 
-static union
+static TLS union
 {
    dble_vec_t vec[12];
    int num[96];
@@ -525,6 +534,8 @@ void ranlxd(double r[],int n)
    if (init==0)
       rlxd_init(1,1);
 
+   STATS_ADD(rng,n);
+
    for (k=0;k<n;k++) 
    {
       is=next[is];
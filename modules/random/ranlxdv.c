@@ -0,0 +1,394 @@
+
+/*******************************************************************************
+*
+* File ranlxdv.c
+*
+* Vectorized version of ranlxd, producing several independent streams in
+* lock step. Stream s is the same sequence that ranlxd would produce after
+* rlxd_init(level,seed+s).
+*
+* The state of all the streams is stored lane by lane, so that each step of
+* the recursion updates all of them with the same instructions. The update
+* is compiled for the default target, for AVX2 and for AVX-512, and the
+* version is selected at run time from the features of the CPU (CPUID).
+*
+* The externally accessible functions are
+*
+*   void rlxdv_init(int nstream,int level,int seed)
+*     Initialization of "nstream" streams (at most RLXDV_MAX), the luxury
+*     level is the same as in rlxd_init and stream s is seeded with seed+s
+*
+*   void ranlxdv(double r[],int n)
+*     Computes the next n double-precision random numbers of each stream
+*     and assigns them to r[k*nstream+s] (k=0,...,n-1, s=0,...,nstream-1)
+*
+*   int rlxdv_streams(void)
+*     Returns the number of streams (0 if the generator is not initialized)
+*
+*   const char *rlxdv_isa(void)
+*     Returns the instruction set used by the update ("avx512f", "avx2"
+*     or "generic")
+*
+*   int rlxdv_size(void)
+*     Returns the number of integers required to save the state of
+*     the generator
+*
+*   void rlxdv_get(int state[])
+*     Extracts the current state of the generator and stores the
+*     information in the array state[N] where N>=rlxdv_size()
+*
+*   void rlxdv_reset(int state[])
+*     Resets the generator to the state defined by the array state[N]
+*
+* The state of the generator is private to each thread, as for ranlxd:
+* every thread starts from the default initialization (rlxdv_init(1,1,1))
+* and should call rlxdv_init with its own seed
+*
+*******************************************************************************/
+#define RANLXDV_C
+
+#include <limits.h>
+#include <float.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "start.h"
+#include "stats.h"
+#include "random.h"
+
+#define TLS __thread
+
+#define BASE 0x1000000
+#define MASK 0xffffff
+#define LANES (4*RLXDV_MAX)
+
+#if (defined __GNUC__)&&((defined __x86_64__)||(defined __i386__))
+#define RLXDV_DISPATCH
+#endif
+
+static TLS int init=0,constants=0,ns=0,nl,pr,prm,ir,jr,is,is_old,next[96];
+static TLS double one_bit;
+
+/* x[v][h][l]: vector v, half h, lane l=4*stream+component */
+
+static TLS int x[12][2][LANES] __attribute__ ((aligned (64)));
+static TLS int carry[LANES] __attribute__ ((aligned (64)));
+
+static TLS void (*update)(void)=NULL;
+static TLS const char *isa="generic";
+
+
+static inline __attribute__ ((always_inline)) void update_body(void)
+{
+   int k,l,d,kmax,i,j,nlanes;
+   int *pi1,*pi2,*pj1,*pj2;
+
+   kmax=pr;
+   nlanes=nl;
+   i=ir;
+   j=jr;
+
+   for (k=0;k<kmax;k++)
+   {
+      pi1=x[i][0];
+      pi2=x[i][1];
+      pj1=x[j][0];
+      pj2=x[j][1];
+
+      for (l=0;l<nlanes;l++)
+      {
+         d=pj1[l]-pi1[l]-carry[l];
+         pi2[l]+=(d<0);
+         d+=BASE;
+         pi1[l]=d&MASK;
+         d=pj2[l]-pi2[l];
+         carry[l]=(d<0);
+         d+=BASE;
+         pi2[l]=d&MASK;
+      }
+
+      i+=1;
+      j+=1;
+      if (i==12)
+         i=0;
+      if (j==12)
+         j=0;
+   }
+
+   ir+=prm;
+   jr+=prm;
+   if (ir>=12)
+      ir-=12;
+   if (jr>=12)
+      jr-=12;
+   is=8*ir;
+   is_old=is;
+}
+
+
+static void update_generic(void)
+{
+   update_body();
+}
+
+#ifdef RLXDV_DISPATCH
+
+__attribute__ ((target ("avx2")))
+static void update_avx2(void)
+{
+   update_body();
+}
+
+__attribute__ ((target ("avx512f")))
+static void update_avx512(void)
+{
+   update_body();
+}
+
+#endif
+
+
+static void select_update(void)
+{
+   update=update_generic;
+   isa="generic";
+
+#ifdef RLXDV_DISPATCH
+   __builtin_cpu_init();
+
+   if (__builtin_cpu_supports("avx512f"))
+   {
+      update=update_avx512;
+      isa="avx512f";
+   }
+   else if (__builtin_cpu_supports("avx2"))
+   {
+      update=update_avx2;
+      isa="avx2";
+   }
+#endif
+}
+
+
+static void define_constants(void)
+{
+   int k;
+
+   if (constants)
+      return;
+
+   one_bit=ldexp(1.0,-24);
+
+   for (k=0;k<96;k++)
+   {
+      next[k]=(k+1)%96;
+      if ((k%4)==3)
+         next[k]=(k+5)%96;
+   }
+
+   select_update();
+   constants=1;
+}
+
+
+void rlxdv_init(int nstream,int level,int seed)
+{
+   int i,k,l,s;
+   int ibit,jbit,xbit[31];
+   int ix,iy;
+
+   error((INT_MAX<2147483647)||(FLT_RADIX!=2)||(FLT_MANT_DIG<24)||
+         (DBL_MANT_DIG<48),1,"rlxdv_init [ranlxdv.c]",
+         "Arithmetic on this machine is not suitable for ranlxdv");
+
+   define_constants();
+
+   error((nstream<1)||(nstream>RLXDV_MAX),1,"rlxdv_init [ranlxdv.c]",
+         "Bad number of streams (should be between 1 and RLXDV_MAX)");
+
+   error((level<1)||(level>2),1,"rlxdv_init [ranlxdv.c]",
+         "Bad choice of luxury level (should be 1 or 2)");
+
+   error((seed<=0)||(seed>INT_MAX-nstream+1),1,"rlxdv_init [ranlxdv.c]",
+         "Bad choice of seed (should be between 1 and 2^31-nstream)");
+
+   if (level==1)
+      pr=202;
+   else
+      pr=397;
+
+   ns=nstream;
+   nl=4*ns;
+
+   for (s=0;s<ns;s++)
+   {
+      i=seed+s;
+
+      for (k=0;k<31;k++)
+      {
+         xbit[k]=i%2;
+         i/=2;
+      }
+
+      ibit=0;
+      jbit=18;
+
+      for (i=0;i<4;i++)
+      {
+         for (k=0;k<24;k++)
+         {
+            ix=0;
+
+            for (l=0;l<24;l++)
+            {
+               iy=xbit[ibit];
+               ix=2*ix+iy;
+
+               xbit[ibit]=(xbit[ibit]+xbit[jbit])%2;
+               ibit=(ibit+1)%31;
+               jbit=(jbit+1)%31;
+            }
+
+            if ((k%4)!=i)
+               ix=16777215-ix;
+
+            x[k/2][k%2][4*s+i]=ix;
+         }
+      }
+
+      for (i=0;i<4;i++)
+         carry[4*s+i]=0;
+   }
+
+   ir=0;
+   jr=7;
+   is=91;
+   is_old=0;
+   prm=pr%12;
+   init=1;
+}
+
+
+void ranlxdv(double r[],int n)
+{
+   int k,s,v,h,c;
+   int *lo,*hi;
+
+   if (init==0)
+      rlxdv_init(1,1,1);
+
+   STATS_ADD(rng,n*ns);
+
+   for (k=0;k<n;k++)
+   {
+      is=next[is];
+      if (is==is_old)
+         update();
+
+      /* number "is" of the scalar generator: vector is/8, half (is%8)/4 */
+      v=is/8;
+      h=(is%8)/4;
+      c=is%4;
+      lo=x[v][h];
+      hi=(h==0) ? x[v][1] : x[(v+1)%12][0];
+
+      for (s=0;s<ns;s++)
+         r[k*ns+s]=one_bit*((double)(hi[4*s+c])+one_bit*(double)(lo[4*s+c]));
+   }
+}
+
+
+int rlxdv_streams(void)
+{
+   return(ns);
+}
+
+
+const char *rlxdv_isa(void)
+{
+   if (update==NULL)
+      select_update();
+
+   return(isa);
+}
+
+
+int rlxdv_size(void)
+{
+   return(6+100*ns);
+}
+
+
+void rlxdv_get(int state[])
+{
+   int v,h,l;
+
+   error(init==0,1,"rlxdv_get [ranlxdv.c]",
+         "Undefined state (ranlxdv is not initialized)");
+
+   state[0]=rlxdv_size();
+   state[1]=ns;
+   state[2]=pr;
+   state[3]=ir;
+   state[4]=jr;
+   state[5]=is;
+
+   for (v=0;v<12;v++)
+      for (h=0;h<2;h++)
+         for (l=0;l<nl;l++)
+            state[6+(8*v+4*h)*ns+l]=x[v][h][l];
+
+   for (l=0;l<nl;l++)
+      state[6+96*ns+l]=carry[l];
+}
+
+
+void rlxdv_reset(int state[])
+{
+   int v,h,l,k;
+
+   error((INT_MAX<2147483647)||(FLT_RADIX!=2)||(FLT_MANT_DIG<24)||
+         (DBL_MANT_DIG<48),1,"rlxdv_reset [ranlxdv.c]",
+         "Arithmetic on this machine is not suitable for ranlxdv");
+
+   define_constants();
+
+   error((state[1]<1)||(state[1]>RLXDV_MAX),1,"rlxdv_reset [ranlxdv.c]",
+         "Unexpected input data");
+
+   ns=state[1];
+   nl=4*ns;
+
+   error(state[0]!=rlxdv_size(),1,"rlxdv_reset [ranlxdv.c]",
+         "Unexpected input data");
+
+   for (v=0;v<12;v++)
+      for (h=0;h<2;h++)
+         for (l=0;l<nl;l++)
+         {
+            k=state[6+(8*v+4*h)*ns+l];
+            error((k<0)||(k>MASK),1,"rlxdv_reset [ranlxdv.c]",
+                  "Unexpected input data");
+            x[v][h][l]=k;
+         }
+
+   for (l=0;l<nl;l++)
+   {
+      error((state[6+96*ns+l]!=0)&&(state[6+96*ns+l]!=1),1,
+            "rlxdv_reset [ranlxdv.c]","Unexpected input data");
+      carry[l]=state[6+96*ns+l];
+   }
+
+   pr=state[2];
+   ir=state[3];
+   jr=state[4];
+   is=state[5];
+   is_old=8*ir;
+   prm=pr%12;
+   init=1;
+
+   error(((pr!=202)&&(pr!=397))||
+         (ir<0)||(ir>11)||(jr<0)||(jr>11)||(jr!=((ir+7)%12))||
+         (is<0)||(is>91),1,
+         "rlxdv_reset [ranlxdv.c]","Unexpected input data");
+}
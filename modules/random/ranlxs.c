@@ -31,6 +31,10 @@
 *   void rlxs_reset(int state[])
 *     Resets the generator to the state defined by the array state[N]
 *
+* The state of the generator is private to each thread: threads other than
+* the main one start from the default initialization (rlxs_init(0,1)) and
+* should call rlxs_init with their own seed
+*
 * Version: 3.0
 * Author: Martin Luescher <luscher@mail.cern.ch>
 *
@@ -43,8 +47,11 @@
 #include <stdio.h>
 #include <math.h>
 #include "start.h"
+#include "stats.h"
+
+#define TLS __thread
 
-#if ((defined SSE)||(defined SSE2))
+#if ((defined SSE)||(defined SSE2))&&((defined __x86_64__)||(defined __i386__))
 
 typedef struct
 {
@@ -56,10 +63,10 @@ typedef struct
    vec_t c1,c2;
 } dble_vec_t __attribute__ ((aligned (16)));
 
-static int init=0,pr,prm,ir,jr,is,is_old,next[96];
-static vec_t one,one_bit,carry;
+static TLS int init=0,pr,prm,ir,jr,is,is_old,next[96];
+static TLS vec_t one,one_bit,carry;
 
-static union
+static TLS union
 {
    dble_vec_t vec[12];
    float num[96];
@@ -238,6 +245,8 @@ void ranlxs(float r[],int n)
    if (init==0)
       rlxs_init(0,1);
 
+   STATS_ADD(rng,n);
+
    for (k=0;k<n;k++) 
    {
       is=next[is];
@@ -337,11 +346,11 @@ typedef struct
    vec_t c1,c2;
 } dble_vec_t;
 
-static int init=0,pr,prm,ir,jr,is,is_old,next[96];
-static float one_bit;
-static vec_t carry;
+static TLS int init=0,pr,prm,ir,jr,is,is_old,next[96];
+static TLS float one_bit;
+static TLS vec_t carry;
 
-static union
+static TLS union
 {
    dble_vec_t vec[12];
    int num[96];
@@ -506,6 +515,8 @@ void ranlxs(float r[],int n)
    if (init==0)
       rlxs_init(0,1);
 
+   STATS_ADD(rng,n);
+
    for (k=0;k<n;k++) 
    {
       is=next[is];
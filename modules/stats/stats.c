@@ -0,0 +1,91 @@
+
+/*******************************************************************************
+*
+* File stats.c
+*
+* Counters and timers of the hot paths (see stats.h)
+*
+* The externally accessible functions are
+*
+*   void stats_start(int phase)
+*     Starts the timer of the phase "phase" (STATS_PREPATTERN, ...)
+*
+*   void stats_stop(int phase)
+*     Stops the timer of the phase "phase", and adds the elapsed time and
+*     the number of steps taken since stats_start to the phase
+*
+*   void stats_report(const char *program)
+*     Prints to stderr a report of the run in JSON format, with counters,
+*     time and throughput of each phase
+*
+*******************************************************************************/
+
+#define STATS_C
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "stats.h"
+
+stats_t poni_stats;
+
+#define STEPS() __atomic_load_n(&poni_stats.steps,__ATOMIC_RELAXED)
+
+static const char *phase_name[STATS_NPHASE]={"prepattern","pattern","output"};
+static double t_first=-1.0,t_start[STATS_NPHASE];
+static long long s_start[STATS_NPHASE];
+
+
+static double now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+
+   return (double)(ts.tv_sec)+1.0e-9*(double)(ts.tv_nsec);
+}
+
+
+void stats_start(int phase)
+{
+   t_start[phase]=now();
+   s_start[phase]=STEPS();
+
+   if (t_first<0.0)
+      t_first=t_start[phase];
+}
+
+
+void stats_stop(int phase)
+{
+   poni_stats.time[phase]+=now()-t_start[phase];
+   poni_stats.phaseSteps[phase]+=STEPS()-s_start[phase];
+}
+
+
+void stats_report(const char *program)
+{
+   int k;
+   double total,rate;
+
+   total=(t_first<0.0) ? 0.0 : now()-t_first;
+
+   fprintf(stderr,"{\"program\": \"%s\", \"wall_time\": %.6f,\n",program,total);
+   fprintf(stderr," \"counters\": {\"steps\": %lld, \"setProdR\": %lld, "
+           "\"noise_redraws\": %lld, \"rng_numbers\": %lld},\n",
+           poni_stats.steps,poni_stats.prodR,poni_stats.redraws,poni_stats.rng);
+   fprintf(stderr," \"phases\": {");
+
+   for (k=0;k<STATS_NPHASE;k++)
+   {
+      rate=(poni_stats.time[k]>0.0) ?
+         (double)(poni_stats.phaseSteps[k])/poni_stats.time[k] : 0.0;
+      fprintf(stderr,"%s\n  \"%s\": {\"time\": %.6f, \"steps\": %lld, "
+              "\"steps_per_s\": %.6e}",(k>0) ? "," : "",phase_name[k],
+              poni_stats.time[k],poni_stats.phaseSteps[k],rate);
+   }
+
+   rate=(total>0.0) ? (double)(poni_stats.steps)/total : 0.0;
+   fprintf(stderr,"},\n \"steps_per_s\": %.6e}\n",rate);
+}